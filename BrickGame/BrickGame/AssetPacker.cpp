@@ -0,0 +1,239 @@
+/*Asset pack builder. Decodes PNGs and WAVs once and writes them to a pack the
+game maps at startup instead of decoding them, see BrickPack.h.
+
+Usage: AssetPacker out.pack file...
+
+.png files are color keyed like LTexture::loadFromFile and converted to
+packPixelFormat, .wav files are converted to the mixer output format. Entries
+are named after the file name without its directory.*/
+
+#include "BrickPack.h"
+#include <SDL_image.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+//One decoded asset waiting to be written
+struct packitem
+{
+	packentry entry;
+	std::vector<Uint8> data;
+};
+
+//The file name part of path
+const char* baseName( const char* path )
+{
+	const char* name = path;
+	for( const char* c = path; *c != '\0'; c++ )
+	{
+		if( *c == '/' || *c == '\\' )
+		{
+			name = c + 1;
+		}
+	}
+	return name;
+}
+
+bool endsWith( const std::string& s, const char* suffix )
+{
+	size_t n = strlen( suffix );
+	return s.size() >= n && s.compare( s.size() - n, n, suffix ) == 0;
+}
+
+bool packImage( const char* path, packitem& item )
+{
+	SDL_Surface* loadedSurface = IMG_Load( path );
+	if( loadedSurface == NULL )
+	{
+		printf( "Unable to load image %s! SDL_image Error: %s\n", path, IMG_GetError() );
+		return false;
+	}
+
+	//Color key image, converting to a format with alpha turns keyed pixels transparent
+	SDL_SetColorKey( loadedSurface, SDL_TRUE, SDL_MapRGB( loadedSurface->format, 0, 0xFF, 0xFF ) );
+	SDL_Surface* converted = SDL_ConvertSurfaceFormat( loadedSurface, packPixelFormat, 0 );
+	SDL_FreeSurface( loadedSurface );
+	if( converted == NULL )
+	{
+		printf( "Unable to convert %s! SDL Error: %s\n", path, SDL_GetError() );
+		return false;
+	}
+
+	//Rows are stored tightly packed
+	int rowBytes = converted->w * 4;
+	item.data.resize( rowBytes * converted->h );
+	for( int y = 0; y < converted->h; y++ )
+	{
+		memcpy( &item.data[y * rowBytes], (Uint8*)converted->pixels + y * converted->pitch, rowBytes );
+	}
+
+	item.entry.type = PACK_IMAGE;
+	item.entry.info[0] = converted->w;
+	item.entry.info[1] = converted->h;
+	item.entry.info[2] = rowBytes;
+	item.entry.info[3] = packPixelFormat;
+
+	SDL_FreeSurface( converted );
+	return true;
+}
+
+bool packSound( const char* path, packitem& item )
+{
+	SDL_AudioSpec spec;
+	Uint8* buffer = NULL;
+	Uint32 length = 0;
+	if( SDL_LoadWAV( path, &spec, &buffer, &length ) == NULL )
+	{
+		printf( "Unable to load sound %s! SDL Error: %s\n", path, SDL_GetError() );
+		return false;
+	}
+
+	//Convert to what the game opens the mixer with
+	SDL_AudioCVT cvt;
+	if( SDL_BuildAudioCVT( &cvt, spec.format, spec.channels, spec.freq, mixerFormat, mixerChannels, mixerFrequency ) < 0 )
+	{
+		printf( "Unable to convert %s! SDL Error: %s\n", path, SDL_GetError() );
+		SDL_FreeWAV( buffer );
+		return false;
+	}
+
+	cvt.len = length;
+	std::vector<Uint8> samples( length * ( cvt.len_mult > 0 ? cvt.len_mult : 1 ) );
+	memcpy( &samples[0], buffer, length );
+	SDL_FreeWAV( buffer );
+
+	cvt.buf = &samples[0];
+	if( cvt.needed && SDL_ConvertAudio( &cvt ) < 0 )
+	{
+		printf( "Unable to convert %s! SDL Error: %s\n", path, SDL_GetError() );
+		return false;
+	}
+
+	item.data.assign( samples.begin(), samples.begin() + ( cvt.needed ? cvt.len_cvt : length ) );
+
+	item.entry.type = PACK_SOUND;
+	item.entry.info[0] = mixerFrequency;
+	item.entry.info[1] = mixerFormat;
+	item.entry.info[2] = mixerChannels;
+	item.entry.info[3] = 0;
+	return true;
+}
+
+bool writePack( const char* path, std::vector<packitem>& items )
+{
+	packheader header;
+	header.magic = packMagic;
+	header.version = packVersion;
+	header.byteOrder = 0x01020304;
+	header.numEntries = items.size();
+
+	//Lay the data out after the table of contents
+	Uint32 offset = sizeof( packheader ) + items.size() * sizeof( packentry );
+	for( int i = 0; i < items.size(); i++ )
+	{
+		offset = ( offset + packAlignment - 1 ) / packAlignment * packAlignment;
+		items[i].entry.offset = offset;
+		items[i].entry.size = items[i].data.size();
+		offset += items[i].entry.size;
+	}
+
+	FILE* file = fopen( path, "wb" );
+	if( file == NULL )
+	{
+		printf( "Unable to open %s for writing!\n", path );
+		return false;
+	}
+
+	bool success = fwrite( &header, sizeof( header ), 1, file ) == 1;
+	for( int i = 0; i < items.size() && success; i++ )
+	{
+		success = fwrite( &items[i].entry, sizeof( packentry ), 1, file ) == 1;
+	}
+
+	for( int i = 0; i < items.size() && success; i++ )
+	{
+		//Pad up to the entry's aligned offset
+		static const Uint8 zeros[packAlignment] = { 0 };
+		long position = ftell( file );
+		success = fwrite( zeros, 1, items[i].entry.offset - position, file ) == items[i].entry.offset - position;
+
+		if( success && !items[i].data.empty() )
+		{
+			success = fwrite( &items[i].data[0], items[i].data.size(), 1, file ) == 1;
+		}
+	}
+
+	if( fclose( file ) != 0 || !success )
+	{
+		printf( "Unable to write %s!\n", path );
+		return false;
+	}
+
+	return true;
+}
+
+int main( int argc, char* args[] )
+{
+	if( argc < 3 )
+	{
+		printf( "Usage: AssetPacker out.pack file...\n" );
+		return 1;
+	}
+
+	//Only the surface and audio conversion code is used, no window or device is opened
+	if( SDL_Init( 0 ) < 0 || !( IMG_Init( IMG_INIT_PNG ) & IMG_INIT_PNG ) )
+	{
+		printf( "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
+		return 1;
+	}
+
+	bool success = true;
+	std::vector<packitem> items;
+	for( int i = 2; i < argc && success; i++ )
+	{
+		packitem item;
+		memset( &item.entry, 0, sizeof( item.entry ) );
+
+		const char* name = baseName( args[i] );
+		if( strlen( name ) >= sizeof( item.entry.name ) )
+		{
+			printf( "Asset name %s is too long!\n", name );
+			success = false;
+			break;
+		}
+		strcpy( item.entry.name, name );
+
+		std::string path = args[i];
+		if( endsWith( path, ".png" ) )
+		{
+			success = packImage( args[i], item );
+		}
+		else if( endsWith( path, ".wav" ) )
+		{
+			success = packSound( args[i], item );
+		}
+		else
+		{
+			printf( "Don't know how to pack %s\n", args[i] );
+			success = false;
+		}
+
+		items.push_back( item );
+	}
+
+	if( success )
+	{
+		success = writePack( args[1], items );
+	}
+
+	if( success )
+	{
+		printf( "Packed %d assets into %s\n", (int)items.size(), args[1] );
+	}
+
+	IMG_Quit();
+	SDL_Quit();
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+/*Sprite atlas packer. Cuts the sprites listed in a manifest out of their sheets,
+packs them into one image and writes a header with the clip of each sprite, so
+the game loads every sprite with one decode and one texture upload.
+
+Usage: AtlasPacker manifest mediadir atlas.png BrickAtlas.h
+
+Manifest lines are "name sheet x y w h", blank lines and lines starting with #
+are skipped. Sheet pixels in the game's cyan color key come out transparent.*/
+
+#include <SDL.h>
+#include <SDL_image.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+//Transparent gutter left around each sprite so filtering never samples a neighbour
+const int atlasPadding = 1;
+
+//One sprite to pack
+struct atlassprite
+{
+	std::string name;
+	std::string sheet;
+	SDL_Rect source;
+
+	//Where it ends up in the atlas
+	SDL_Rect clip;
+};
+
+//Smallest power of two no less than n
+int powerOfTwo( int n )
+{
+	int p = 1;
+	while( p < n )
+	{
+		p *= 2;
+	}
+	return p;
+}
+
+//Taller sprites go first, sprites of the same height keep manifest order
+bool tallerFirst( const atlassprite* a, const atlassprite* b )
+{
+	return a->source.h > b->source.h;
+}
+
+bool readManifest( const char* path, std::vector<atlassprite>& sprites )
+{
+	FILE* file = fopen( path, "r" );
+	if( file == NULL )
+	{
+		printf( "Unable to open manifest %s!\n", path );
+		return false;
+	}
+
+	bool success = true;
+	char line[256];
+	for( int lineNumber = 1; fgets( line, sizeof( line ), file ) != NULL; lineNumber++ )
+	{
+		char name[64];
+		char sheet[128];
+		atlassprite s;
+
+		if( line[0] == '#' || sscanf( line, "%63s", name ) != 1 )
+		{
+			continue;
+		}
+
+		if( sscanf( line, "%63s %127s %d %d %d %d", name, sheet, &s.source.x, &s.source.y, &s.source.w, &s.source.h ) != 6 )
+		{
+			printf( "%s:%d: expected name sheet x y w h\n", path, lineNumber );
+			success = false;
+			continue;
+		}
+
+		s.name = name;
+		s.sheet = sheet;
+		sprites.push_back( s );
+	}
+
+	fclose( file );
+	return success;
+}
+
+//Shelf packing: sprites fill rows left to right, a row is as tall as its first sprite
+void pack( std::vector<atlassprite>& sprites, int& width, int& height )
+{
+	std::vector<atlassprite*> order;
+	int widest = 0;
+	for( int i = 0; i < sprites.size(); i++ )
+	{
+		order.push_back( &sprites[i] );
+		widest = std::max( widest, sprites[i].source.w + atlasPadding );
+	}
+	std::stable_sort( order.begin(), order.end(), tallerFirst );
+
+	width = powerOfTwo( widest );
+
+	int x = 0;
+	int y = 0;
+	int shelfHeight = 0;
+	for( int i = 0; i < order.size(); i++ )
+	{
+		SDL_Rect& clip = order[i]->clip;
+		clip.w = order[i]->source.w;
+		clip.h = order[i]->source.h;
+
+		if( x + clip.w + atlasPadding > width )
+		{
+			y += shelfHeight;
+			x = 0;
+			shelfHeight = 0;
+		}
+
+		clip.x = x;
+		clip.y = y;
+		x += clip.w + atlasPadding;
+		shelfHeight = std::max( shelfHeight, clip.h + atlasPadding );
+	}
+
+	height = powerOfTwo( y + shelfHeight );
+}
+
+//Copies every sprite into a transparent width x height image and saves it
+bool writeAtlas( const char* mediaDir, const char* path, std::vector<atlassprite>& sprites, int width, int height )
+{
+	SDL_Surface* atlas = SDL_CreateRGBSurface( 0, width, height, 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 );
+	if( atlas == NULL )
+	{
+		printf( "Unable to create atlas surface! SDL Error: %s\n", SDL_GetError() );
+		return false;
+	}
+	SDL_FillRect( atlas, NULL, 0 );
+
+	bool success = true;
+	for( int i = 0; i < sprites.size() && success; i++ )
+	{
+		std::string sheetPath = std::string( mediaDir ) + "/" + sprites[i].sheet;
+		SDL_Surface* sheet = IMG_Load( sheetPath.c_str() );
+		if( sheet == NULL )
+		{
+			printf( "Unable to load image %s! SDL_image Error: %s\n", sheetPath.c_str(), IMG_GetError() );
+			success = false;
+			break;
+		}
+
+		//Same color key the game used on the separate sheets. Copy alpha as is rather than blending it.
+		SDL_SetColorKey( sheet, SDL_TRUE, SDL_MapRGB( sheet->format, 0, 0xFF, 0xFF ) );
+		SDL_SetSurfaceBlendMode( sheet, SDL_BLENDMODE_NONE );
+
+		SDL_Rect clip = sprites[i].clip;
+		if( SDL_BlitSurface( sheet, &sprites[i].source, atlas, &clip ) < 0 )
+		{
+			printf( "Unable to copy sprite %s! SDL Error: %s\n", sprites[i].name.c_str(), SDL_GetError() );
+			success = false;
+		}
+
+		SDL_FreeSurface( sheet );
+	}
+
+	if( success && IMG_SavePNG( atlas, path ) < 0 )
+	{
+		printf( "Unable to save %s! SDL_image Error: %s\n", path, IMG_GetError() );
+		success = false;
+	}
+
+	SDL_FreeSurface( atlas );
+	return success;
+}
+
+//Writes the clip table, sprites are listed in manifest order
+bool writeHeader( const char* path, const char* manifest, std::vector<atlassprite>& sprites, int width, int height )
+{
+	FILE* file = fopen( path, "w" );
+	if( file == NULL )
+	{
+		printf( "Unable to open %s for writing!\n", path );
+		return false;
+	}
+
+	fprintf( file, "/*Sprite clips in media/atlas.png. Generated by AtlasPacker from media/%s, do not edit.*/\n\n", manifest );
+	fprintf( file, "#pragma once\n\n#include <SDL.h>\n\n" );
+	fprintf( file, "const int atlasWidth = %d;\nconst int atlasHeight = %d;\n\n", width, height );
+
+	fprintf( file, "enum atlassprite\n{\n" );
+	for( int i = 0; i < sprites.size(); i++ )
+	{
+		std::string id = "ATLAS_";
+		for( int c = 0; c < sprites[i].name.size(); c++ )
+		{
+			id += (char)toupper( (unsigned char)sprites[i].name[c] );
+		}
+		fprintf( file, "\t%s,\n", id.c_str() );
+	}
+	fprintf( file, "\tATLAS_SPRITE_COUNT\n};\n\n" );
+
+	fprintf( file, "const SDL_Rect atlasClips[ATLAS_SPRITE_COUNT] =\n{\n" );
+	for( int i = 0; i < sprites.size(); i++ )
+	{
+		const SDL_Rect& c = sprites[i].clip;
+		fprintf( file, "\t{ %d, %d, %d, %d },\t//%s\n", c.x, c.y, c.w, c.h, sprites[i].name.c_str() );
+	}
+	fprintf( file, "};\n" );
+
+	fclose( file );
+	return true;
+}
+
+int main( int argc, char* args[] )
+{
+	if( argc != 5 )
+	{
+		printf( "Usage: AtlasPacker manifest mediadir atlas.png BrickAtlas.h\n" );
+		return 1;
+	}
+
+	std::vector<atlassprite> sprites;
+	if( !readManifest( args[1], sprites ) || sprites.empty() )
+	{
+		printf( "No sprites to pack!\n" );
+		return 1;
+	}
+
+	int width, height;
+	pack( sprites, width, height );
+
+	//Only the surface code is used, no window is opened
+	if( SDL_Init( 0 ) < 0 || !( IMG_Init( IMG_INIT_PNG ) & IMG_INIT_PNG ) )
+	{
+		printf( "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
+		return 1;
+	}
+
+	//The header names the manifest without its directory so it reads the same wherever it was built
+	const char* manifestName = args[1];
+	for( const char* c = args[1]; *c != '\0'; c++ )
+	{
+		if( *c == '/' || *c == '\\' )
+		{
+			manifestName = c + 1;
+		}
+	}
+
+	bool success = writeAtlas( args[2], args[3], sprites, width, height ) && writeHeader( args[4], manifestName, sprites, width, height );
+	if( success )
+	{
+		printf( "Packed %d sprites into %dx%d\n", (int)sprites.size(), width, height );
+	}
+
+	IMG_Quit();
+	SDL_Quit();
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+/*Asset loading on a pool of worker threads.*/
+
+#include "BrickAssets.h"
+#include <SDL_image.h>
+#include <stdio.h>
+
+LAssetLoader::LAssetLoader()
+{
+	//Initialize
+	mWorkers = 0;
+	SDL_AtomicSet( &mNext, 0 );
+	SDL_AtomicSet( &mDone, 0 );
+}
+
+LAssetLoader::~LAssetLoader()
+{
+	//Workers write into mJobs, they must be gone before it is
+	wait();
+}
+
+void LAssetLoader::addImage( const std::string& path, SDL_Surface** result )
+{
+	assetjob job = { JOB_IMAGE, path, result, NULL, false };
+	mJobs.push_back( job );
+}
+
+void LAssetLoader::addSound( const std::string& path, Mix_Chunk** result )
+{
+	assetjob job = { JOB_SOUND, path, result, NULL, false };
+	mJobs.push_back( job );
+}
+
+void LAssetLoader::addJob( assetdecoder decoder, void* data )
+{
+	assetjob job = { JOB_CUSTOM, "", data, decoder, false };
+	mJobs.push_back( job );
+}
+
+bool LAssetLoader::start( int numWorkers )
+{
+	if( numWorkers <= 0 )
+	{
+		numWorkers = SDL_GetCPUCount();
+	}
+	if( numWorkers > (int)mJobs.size() )
+	{
+		numWorkers = mJobs.size();
+	}
+
+	for( int i = 0; i < numWorkers; i++ )
+	{
+		SDL_Thread* thread = SDL_CreateThread( work, "AssetWorker", this );
+		if( thread == NULL )
+		{
+			printf( "Unable to start asset worker! SDL Error: %s\n", SDL_GetError() );
+			break;
+		}
+		mThreads.push_back( thread );
+	}
+
+	mWorkers = mThreads.size();
+
+	//Without any workers the jobs still get done, just on this thread
+	if( mThreads.empty() && !mJobs.empty() )
+	{
+		work( this );
+	}
+
+	return !mThreads.empty();
+}
+
+int LAssetLoader::getDone()
+{
+	return SDL_AtomicGet( &mDone );
+}
+
+int LAssetLoader::getTotal()
+{
+	return mJobs.size();
+}
+
+bool LAssetLoader::finished()
+{
+	return getDone() == getTotal();
+}
+
+bool LAssetLoader::wait()
+{
+	for( int i = 0; i < mThreads.size(); i++ )
+	{
+		SDL_WaitThread( mThreads[i], NULL );
+	}
+	mThreads.clear();
+
+	bool success = true;
+	for( int i = 0; i < mJobs.size(); i++ )
+	{
+		success = success && mJobs[i].ok;
+	}
+	return success;
+}
+
+int LAssetLoader::getWorkers()
+{
+	return mWorkers;
+}
+
+void LAssetLoader::run( assetjob& job )
+{
+	switch( job.type )
+	{
+		case JOB_IMAGE:
+		{
+			SDL_Surface* surface = IMG_Load( job.path.c_str() );
+			if( surface == NULL )
+			{
+				printf( "Unable to load image %s! SDL_image Error: %s\n", job.path.c_str(), IMG_GetError() );
+			}
+			else
+			{
+				//Color key image
+				SDL_SetColorKey( surface, SDL_TRUE, SDL_MapRGB( surface->format, 0, 0xFF, 0xFF ) );
+			}
+			*(SDL_Surface**)job.result = surface;
+			job.ok = surface != NULL;
+			break;
+		}
+
+		case JOB_SOUND:
+		{
+			Mix_Chunk* chunk = Mix_LoadWAV( job.path.c_str() );
+			if( chunk == NULL )
+			{
+				printf( "Failed to load sound %s! SDL_mixer Error: %s\n", job.path.c_str(), Mix_GetError() );
+			}
+			*(Mix_Chunk**)job.result = chunk;
+			job.ok = chunk != NULL;
+			break;
+		}
+
+		case JOB_CUSTOM:
+		{
+			job.ok = job.decoder( job.result );
+			break;
+		}
+	}
+}
+
+int LAssetLoader::work( void* data )
+{
+	LAssetLoader* loader = (LAssetLoader*)data;
+
+	//Jobs are handed out in queue order, put the slow ones first
+	for( int i = SDL_AtomicAdd( &loader->mNext, 1 ); i < loader->mJobs.size(); i = SDL_AtomicAdd( &loader->mNext, 1 ) )
+	{
+		run( loader->mJobs[i] );
+		SDL_AtomicAdd( &loader->mDone, 1 );
+	}
+
+	return 0;
+}
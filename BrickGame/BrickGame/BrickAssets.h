@@ -0,0 +1,80 @@
+/*Asset loading on a pool of worker threads. Images, sounds and anything else
+that only touches surfaces or files is decoded off the render thread, so file
+reads and decodes overlap. The render thread keeps drawing a loading screen
+and uploads textures once the decodes are done.*/
+
+#pragma once
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <string>
+#include <vector>
+
+//A decode step run on a worker. Returns false if the asset failed to load.
+typedef bool (*assetdecoder)( void* data );
+
+class LAssetLoader
+{
+	public:
+		//Initializes variables
+		LAssetLoader();
+
+		//Waits for any running workers
+		~LAssetLoader();
+
+		//Queues a PNG decode, color keyed like LTexture::loadFromFile. The caller owns the surface.
+		void addImage( const std::string& path, SDL_Surface** result );
+
+		//Queues a WAV load, the audio device must already be open
+		void addSound( const std::string& path, Mix_Chunk** result );
+
+		//Queues any other decode step. It must not use the renderer.
+		void addJob( assetdecoder decoder, void* data );
+
+		//Starts up to numWorkers threads on the queued jobs, 0 picks one per CPU
+		bool start( int numWorkers = 0 );
+
+		//Jobs finished so far and jobs queued
+		int getDone();
+		int getTotal();
+
+		//True once every job has finished
+		bool finished();
+
+		//Waits for the workers, returns false if any job failed
+		bool wait();
+
+		//Workers started by the last start
+		int getWorkers();
+
+	private:
+		enum jobtype
+		{
+			JOB_IMAGE,
+			JOB_SOUND,
+			JOB_CUSTOM
+		};
+
+		struct assetjob
+		{
+			jobtype type;
+			std::string path;
+			void* result;
+			assetdecoder decoder;
+			bool ok;
+		};
+
+		//Runs one job on the calling thread
+		static void run( assetjob& job );
+
+		//Worker entry point, takes jobs until there are none left
+		static int work( void* loader );
+
+		std::vector<assetjob> mJobs;
+		std::vector<SDL_Thread*> mThreads;
+		int mWorkers;
+
+		//Next job to hand out and jobs finished
+		SDL_atomic_t mNext;
+		SDL_atomic_t mDone;
+};
@@ -0,0 +1,35 @@
+/*Sprite clips in media/atlas.png. Generated by AtlasPacker from media/atlas.txt, do not edit.*/
+
+#pragma once
+
+#include <SDL.h>
+
+const int atlasWidth = 1024;
+const int atlasHeight = 256;
+
+enum atlassprite
+{
+	ATLAS_PADDLE,
+	ATLAS_BRICK0,
+	ATLAS_BRICK1,
+	ATLAS_BRICK2,
+	ATLAS_BRICK3,
+	ATLAS_BRICK4,
+	ATLAS_BRICK5,
+	ATLAS_BALL,
+	ATLAS_SCOREBOARD,
+	ATLAS_SPRITE_COUNT
+};
+
+const SDL_Rect atlasClips[ATLAS_SPRITE_COUNT] =
+{
+	{ 801, 0, 200, 24 },	//paddle
+	{ 0, 201, 80, 20 },	//brick0
+	{ 81, 201, 80, 20 },	//brick1
+	{ 162, 201, 80, 20 },	//brick2
+	{ 243, 201, 80, 20 },	//brick3
+	{ 324, 201, 80, 20 },	//brick4
+	{ 405, 201, 80, 20 },	//brick5
+	{ 486, 201, 20, 20 },	//ball
+	{ 0, 0, 800, 200 },	//scoreboard
+};
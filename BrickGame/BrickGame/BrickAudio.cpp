@@ -0,0 +1,231 @@
+/*Sound effects through a fixed pool of mixer voices.*/
+
+#include "BrickAudio.h"
+#include <stdio.h>
+
+LVoicePool::LVoicePool()
+{
+	//Initialize
+	mNumSounds = 0;
+	mVoices = NULL;
+	mNumVoices = 0;
+	mWake = NULL;
+	mThread = NULL;
+	mOrder = 0;
+	SDL_AtomicSet( &mQuit, 0 );
+	SDL_AtomicSet( &mPlayed, 0 );
+	SDL_AtomicSet( &mStolen, 0 );
+	SDL_AtomicSet( &mDropped, 0 );
+}
+
+LVoicePool::~LVoicePool()
+{
+	//Stop the voice thread
+	stop();
+}
+
+int LVoicePool::addSound( Mix_Chunk* chunk, int priority, int maxInstances )
+{
+	if( mNumSounds == maxPoolSounds )
+	{
+		printf( "Voice pool is full, sound not added!\n" );
+		return -1;
+	}
+
+	poolsound s = { chunk, priority, maxInstances > 0 ? maxInstances : 1 };
+	mSounds[mNumSounds] = s;
+	return mNumSounds++;
+}
+
+bool LVoicePool::start( int numVoices )
+{
+	//Get rid of a running pool
+	stop();
+
+	mNumVoices = Mix_AllocateChannels( numVoices );
+	if( mNumVoices < 1 )
+	{
+		printf( "Unable to allocate mixer channels! SDL_mixer Error: %s\n", Mix_GetError() );
+		return false;
+	}
+
+	mVoices = new voice[mNumVoices];
+	for( int v = 0; v < mNumVoices; v++ )
+	{
+		mVoices[v].sound = -1;
+		mVoices[v].order = 0;
+	}
+
+	SDL_AtomicSet( &mQuit, 0 );
+	mWake = SDL_CreateSemaphore( 0 );
+	mThread = mWake != NULL ? SDL_CreateThread( run, "VoicePool", this ) : NULL;
+	if( mThread == NULL )
+	{
+		printf( "Unable to start voice thread! SDL Error: %s\n", SDL_GetError() );
+		stop();
+		return false;
+	}
+
+	return true;
+}
+
+void LVoicePool::stop()
+{
+	if( mThread != NULL )
+	{
+		SDL_AtomicSet( &mQuit, 1 );
+		SDL_SemPost( mWake );
+		SDL_WaitThread( mThread, NULL );
+		mThread = NULL;
+
+		Mix_HaltChannel( -1 );
+	}
+
+	if( mWake != NULL )
+	{
+		SDL_DestroySemaphore( mWake );
+		mWake = NULL;
+	}
+
+	delete[] mVoices;
+	mVoices = NULL;
+	mNumVoices = 0;
+}
+
+void LVoicePool::play( int sound )
+{
+	if( mThread == NULL || sound < 0 || sound >= mNumSounds )
+	{
+		return;
+	}
+
+	//A full queue means the voice thread is far behind, the sound would be late anyway
+	if( !mCommands.push( sound ) )
+	{
+		SDL_AtomicAdd( &mDropped, 1 );
+		return;
+	}
+
+	SDL_SemPost( mWake );
+}
+
+int LVoicePool::getPlayed()
+{
+	return SDL_AtomicGet( &mPlayed );
+}
+
+int LVoicePool::getStolen()
+{
+	return SDL_AtomicGet( &mStolen );
+}
+
+int LVoicePool::getDropped()
+{
+	return SDL_AtomicGet( &mDropped );
+}
+
+void LVoicePool::dispatch( int sound )
+{
+	const poolsound& s = mSounds[sound];
+
+	int instances = 0;
+	int oldestCopy = -1;
+	int freeVoice = -1;
+	int victim = -1;
+
+	for( int v = 0; v < mNumVoices; v++ )
+	{
+		//Voices whose sound has ended are free again
+		if( mVoices[v].sound >= 0 && !Mix_Playing( v ) )
+		{
+			mVoices[v].sound = -1;
+		}
+
+		if( mVoices[v].sound < 0 )
+		{
+			if( freeVoice < 0 )
+			{
+				freeVoice = v;
+			}
+			continue;
+		}
+
+		if( mVoices[v].sound == sound )
+		{
+			instances++;
+			if( oldestCopy < 0 || mVoices[v].order < mVoices[oldestCopy].order )
+			{
+				oldestCopy = v;
+			}
+		}
+
+		//The lowest priority voice no more important than this sound, oldest first, can be stolen
+		int priority = mSounds[mVoices[v].sound].priority;
+		if( priority <= s.priority )
+		{
+			int victimPriority = victim < 0 ? 0 : mSounds[mVoices[victim].sound].priority;
+			if( victim < 0 || priority < victimPriority || ( priority == victimPriority && mVoices[v].order < mVoices[victim].order ) )
+			{
+				victim = v;
+			}
+		}
+	}
+
+	int target;
+	if( instances >= s.maxInstances )
+	{
+		//At the cap the newest hit restarts the oldest copy
+		target = oldestCopy;
+		SDL_AtomicAdd( &mStolen, 1 );
+	}
+	else if( freeVoice >= 0 )
+	{
+		target = freeVoice;
+	}
+	else if( victim >= 0 )
+	{
+		target = victim;
+		SDL_AtomicAdd( &mStolen, 1 );
+	}
+	else
+	{
+		//Every voice is playing something more important
+		SDL_AtomicAdd( &mDropped, 1 );
+		return;
+	}
+
+	//Playing on a busy channel cuts off what was there
+	if( Mix_PlayChannel( target, s.chunk, 0 ) < 0 )
+	{
+		SDL_AtomicAdd( &mDropped, 1 );
+		mVoices[target].sound = -1;
+		return;
+	}
+
+	mVoices[target].sound = sound;
+	mVoices[target].order = ++mOrder;
+	SDL_AtomicAdd( &mPlayed, 1 );
+}
+
+int LVoicePool::run( void* data )
+{
+	LVoicePool* pool = (LVoicePool*)data;
+
+	while( true )
+	{
+		SDL_SemWait( pool->mWake );
+
+		int sound;
+		while( pool->mCommands.pop( sound ) )
+		{
+			pool->dispatch( sound );
+		}
+
+		if( SDL_AtomicGet( &pool->mQuit ) )
+		{
+			break;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+/*Sound effects through a fixed pool of mixer voices. Gameplay code queues play
+commands on a lock-free ring and never calls the mixer itself. A voice thread
+drains the ring and picks a voice for each sound. There is a cap on copies of
+one sound playing at once, and when every voice is busy the lowest priority
+one is stolen.*/
+
+#pragma once
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "BrickRing.h"
+
+//Most sounds that can be registered with one pool
+const int maxPoolSounds = 16;
+
+class LVoicePool
+{
+	public:
+		//Initializes variables
+		LVoicePool();
+
+		//Stops the voice thread
+		~LVoicePool();
+
+		//Registers a loaded chunk and returns its id for play. Higher priority sounds can steal
+		//voices from lower ones, and at most maxInstances copies of it play at once.
+		int addSound( Mix_Chunk* chunk, int priority, int maxInstances );
+
+		//Claims numVoices mixer channels and starts the voice thread. The mixer must be open.
+		bool start( int numVoices );
+
+		//Halts every voice and stops the voice thread
+		void stop();
+
+		//Queues sound to be played. Call from the game thread only, it never blocks.
+		void play( int sound );
+
+		//Sounds played, played on a stolen voice, and dropped since start
+		int getPlayed();
+		int getStolen();
+		int getDropped();
+
+	private:
+		struct poolsound
+		{
+			Mix_Chunk* chunk;
+			int priority;
+			int maxInstances;
+		};
+
+		//What each voice was last given, owned by the voice thread
+		struct voice
+		{
+			int sound;
+			unsigned int order;
+		};
+
+		//Picks a voice for sound and plays it there, runs on the voice thread
+		void dispatch( int sound );
+
+		//Voice thread entry point
+		static int run( void* pool );
+
+		poolsound mSounds[maxPoolSounds];
+		int mNumSounds;
+
+		voice* mVoices;
+		int mNumVoices;
+
+		//Play commands from the game thread, each is a sound id
+		spscring<int, 256> mCommands;
+
+		//Wakes the voice thread when commands arrive
+		SDL_sem* mWake;
+		SDL_Thread* mThread;
+		SDL_atomic_t mQuit;
+
+		//Counts plays so voices can be told apart by age
+		unsigned int mOrder;
+
+		SDL_atomic_t mPlayed;
+		SDL_atomic_t mStolen;
+		SDL_atomic_t mDropped;
+};
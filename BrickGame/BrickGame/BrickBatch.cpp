@@ -0,0 +1,188 @@
+/*Batch circle vs brick collision. Tests a circle against brickBatchWidth bricks
+at once straight from the brickfield arrays and returns a hit mask instead of
+branching per brick.
+
+The maths matches checkCollision: clamp the circle centre to the box, then
+compare the squared distance to r squared. Distances are clamped to +-32767
+first so the squares can never overflow, which changes nothing for any ball
+smaller than that.*/
+
+#include "BrickSim.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BRICKBATCH_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BRICKBATCH_SSE2
+#endif
+
+//Largest axis distance the kernels square
+const int maxBatchDistance = 32767;
+
+static int clampInt( int v, int lo, int hi )
+{
+	return v < lo ? lo : ( v > hi ? hi : v );
+}
+
+//Bit mask with the low count bits set
+static unsigned int laneMask( int count )
+{
+	return count >= 32 ? 0xFFFFFFFFu : ( 1u << count ) - 1;
+}
+
+void checkCollisionBatchScalar( const Circle *circles, int numCircles, const brickfield &field, int first, int count, unsigned int *masks )
+{
+	const int *xs = field.xs() + first;
+	const int *ys = field.ys() + first;
+	const int *ws = field.ws() + first;
+	const int *hs = field.hs() + first;
+
+	for(int c = 0; c < numCircles; c++)
+	{
+		const Circle &a = circles[c];
+		unsigned int mask = 0;
+
+		for(int i = 0; i < count; i++)
+		{
+			int dx = clampInt(clampInt(a.x, xs[i], xs[i] + ws[i]) - a.x, -maxBatchDistance, maxBatchDistance);
+			int dy = clampInt(clampInt(a.y, ys[i], ys[i] + hs[i]) - a.y, -maxBatchDistance, maxBatchDistance);
+
+			if(dx*dx + dy*dy < a.r * a.r)
+			{
+				mask |= 1u << i;
+			}
+		}
+
+		masks[c] = mask;
+	}
+}
+
+#if defined(BRICKBATCH_AVX2)
+
+void checkCollisionBatch( const Circle *circles, int numCircles, const brickfield &field, int first, int count, unsigned int *masks )
+{
+	for(int c = 0; c < numCircles; c++)
+	{
+		masks[c] = 0;
+	}
+
+	const __m256i lo = _mm256_set1_epi32(-maxBatchDistance);
+	const __m256i hi = _mm256_set1_epi32(maxBatchDistance);
+
+	//Bricks on the outside, circles inside, so each batch of bricks is loaded once
+	for(int b = 0; b < count; b += brickBatchWidth)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)(field.xs() + first + b));
+		__m256i y = _mm256_loadu_si256((const __m256i*)(field.ys() + first + b));
+		__m256i right = _mm256_add_epi32(x, _mm256_loadu_si256((const __m256i*)(field.ws() + first + b)));
+		__m256i bottom = _mm256_add_epi32(y, _mm256_loadu_si256((const __m256i*)(field.hs() + first + b)));
+
+		for(int c = 0; c < numCircles; c++)
+		{
+			__m256i ax = _mm256_set1_epi32(circles[c].x);
+			__m256i ay = _mm256_set1_epi32(circles[c].y);
+			__m256i r2 = _mm256_set1_epi32(circles[c].r * circles[c].r);
+
+			__m256i dx = _mm256_sub_epi32(_mm256_min_epi32(_mm256_max_epi32(ax, x), right), ax);
+			__m256i dy = _mm256_sub_epi32(_mm256_min_epi32(_mm256_max_epi32(ay, y), bottom), ay);
+			dx = _mm256_min_epi32(_mm256_max_epi32(dx, lo), hi);
+			dy = _mm256_min_epi32(_mm256_max_epi32(dy, lo), hi);
+
+			__m256i d2 = _mm256_add_epi32(_mm256_mullo_epi32(dx, dx), _mm256_mullo_epi32(dy, dy));
+			unsigned int bits = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(r2, d2)));
+
+			masks[c] |= bits << b;
+		}
+	}
+
+	//Drop anything past count in the last batch
+	for(int c = 0; c < numCircles; c++)
+	{
+		masks[c] &= laneMask(count);
+	}
+}
+
+const char *collisionBatchPath()
+{
+	return "avx2";
+}
+
+#elif defined(BRICKBATCH_SSE2)
+
+//SSE2 has no 32 bit min/max, build them from a compare and a select
+static __m128i min32( __m128i a, __m128i b )
+{
+	__m128i agt = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(agt, b), _mm_andnot_si128(agt, a));
+}
+
+static __m128i max32( __m128i a, __m128i b )
+{
+	__m128i agt = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(agt, a), _mm_andnot_si128(agt, b));
+}
+
+void checkCollisionBatch( const Circle *circles, int numCircles, const brickfield &field, int first, int count, unsigned int *masks )
+{
+	for(int c = 0; c < numCircles; c++)
+	{
+		masks[c] = 0;
+	}
+
+	const __m128i lo = _mm_set1_epi32(-maxBatchDistance);
+	const __m128i hi = _mm_set1_epi32(maxBatchDistance);
+	const __m128i low16 = _mm_set1_epi32(0xFFFF);
+
+	for(int b = 0; b < count; b += 4)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(field.xs() + first + b));
+		__m128i y = _mm_loadu_si128((const __m128i*)(field.ys() + first + b));
+		__m128i right = _mm_add_epi32(x, _mm_loadu_si128((const __m128i*)(field.ws() + first + b)));
+		__m128i bottom = _mm_add_epi32(y, _mm_loadu_si128((const __m128i*)(field.hs() + first + b)));
+
+		for(int c = 0; c < numCircles; c++)
+		{
+			__m128i ax = _mm_set1_epi32(circles[c].x);
+			__m128i ay = _mm_set1_epi32(circles[c].y);
+			__m128i r2 = _mm_set1_epi32(circles[c].r * circles[c].r);
+
+			__m128i dx = _mm_sub_epi32(min32(max32(ax, x), right), ax);
+			__m128i dy = _mm_sub_epi32(min32(max32(ay, y), bottom), ay);
+			dx = min32(max32(dx, lo), hi);
+			dy = min32(max32(dy, lo), hi);
+
+			//Both distances fit in 16 bits now. Pack dx in the low half of each lane and dy
+			//in the high half, then one multiply-add gives dx*dx + dy*dy per lane.
+			__m128i packed = _mm_or_si128(_mm_and_si128(dx, low16), _mm_slli_epi32(dy, 16));
+			__m128i d2 = _mm_madd_epi16(packed, packed);
+			unsigned int bits = (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(r2, d2)));
+
+			masks[c] |= bits << b;
+		}
+	}
+
+	for(int c = 0; c < numCircles; c++)
+	{
+		masks[c] &= laneMask(count);
+	}
+}
+
+const char *collisionBatchPath()
+{
+	return "sse2";
+}
+
+#else
+
+void checkCollisionBatch( const Circle *circles, int numCircles, const brickfield &field, int first, int count, unsigned int *masks )
+{
+	checkCollisionBatchScalar(circles, numCircles, field, first, count, masks);
+}
+
+const char *collisionBatchPath()
+{
+	return "scalar";
+}
+
+#endif
@@ -0,0 +1,236 @@
+/*Archetype entity component system.*/
+
+#include "BrickECS.h"
+#include "BrickTrace.h"
+
+//Circles per chunk handed to a thread
+const int circleGrain = 64;
+
+archetype::archetype( unsigned int mask )
+{
+	mMask = mask;
+}
+
+unsigned int archetype::mask() const
+{
+	return mMask;
+}
+
+int archetype::size() const
+{
+	return entities.size();
+}
+
+bool archetype::has( unsigned int mask ) const
+{
+	return ( mMask & mask ) == mask;
+}
+
+//Appends a zeroed component if the archetype holds it
+template<typename T> static void addComponent( std::vector<T> &column, bool held )
+{
+	if( held )
+	{
+		T zero = T();
+		column.push_back( zero );
+	}
+}
+
+//Fills row from the last row and drops the last, if the archetype holds the component
+template<typename T> static void removeComponent( std::vector<T> &column, int row )
+{
+	if( !column.empty() )
+	{
+		column[row] = column.back();
+		column.pop_back();
+	}
+}
+
+int archetype::addRow( entity e )
+{
+	entities.push_back( e );
+	addComponent( transforms, has( COMPONENT_TRANSFORM ) );
+	addComponent( velocities, has( COMPONENT_VELOCITY ) );
+	addComponent( circles, has( COMPONENT_CIRCLE ) );
+	addComponent( sprites, has( COMPONENT_SPRITE ) );
+	addComponent( contactLists, has( COMPONENT_CONTACTS ) );
+	addComponent( boxes, has( COMPONENT_BOX ) );
+	return entities.size() - 1;
+}
+
+entity archetype::removeRow( int row )
+{
+	entity moved = { (unsigned int)-1, 0 };
+	if( row != size() - 1 )
+	{
+		moved = entities.back();
+	}
+
+	removeComponent( entities, row );
+	removeComponent( transforms, row );
+	removeComponent( velocities, row );
+	removeComponent( circles, row );
+	removeComponent( sprites, row );
+	removeComponent( contactLists, row );
+	removeComponent( boxes, row );
+	return moved;
+}
+
+entityworld::entityworld()
+{
+	mSize = 0;
+}
+
+entity entityworld::create( unsigned int mask )
+{
+	//Reuse a free id or open a new one
+	unsigned int id;
+	if( !mFreeIds.empty() )
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+	}
+	else
+	{
+		id = mRecords.size();
+		entityrecord fresh = { 0, 0, 0, false };
+		mRecords.push_back( fresh );
+	}
+
+	entityrecord &record = mRecords[id];
+	entity e = { id, record.generation };
+	record.archetypeIndex = archetypeFor( mask );
+	record.row = mArchetypes[record.archetypeIndex].addRow( e );
+	record.alive = true;
+	mSize++;
+	return e;
+}
+
+bool entityworld::destroy( entity e )
+{
+	if( !alive( e ) )
+	{
+		return false;
+	}
+
+	entityrecord &record = mRecords[e.id];
+	entity moved = mArchetypes[record.archetypeIndex].removeRow( record.row );
+	if( moved.id != (unsigned int)-1 )
+	{
+		mRecords[moved.id].row = record.row;
+	}
+
+	//Retire the id so its handles go stale
+	record.alive = false;
+	record.generation++;
+	mFreeIds.push_back( e.id );
+	mSize--;
+	return true;
+}
+
+bool entityworld::alive( entity e ) const
+{
+	return e.id < mRecords.size() && mRecords[e.id].alive && mRecords[e.id].generation == e.generation;
+}
+
+void entityworld::clear()
+{
+	for( size_t id = 0; id < mRecords.size(); id++ )
+	{
+		if( mRecords[id].alive )
+		{
+			mRecords[id].alive = false;
+			mRecords[id].generation++;
+			mFreeIds.push_back( id );
+		}
+	}
+
+	for( size_t a = 0; a < mArchetypes.size(); a++ )
+	{
+		archetype &arch = mArchetypes[a];
+		arch.entities.clear();
+		arch.transforms.clear();
+		arch.velocities.clear();
+		arch.circles.clear();
+		arch.sprites.clear();
+		arch.contactLists.clear();
+		arch.boxes.clear();
+	}
+	mSize = 0;
+}
+
+int entityworld::size() const
+{
+	return mSize;
+}
+
+int entityworld::archetypeFor( unsigned int mask )
+{
+	for( size_t a = 0; a < mArchetypes.size(); a++ )
+	{
+		if( mArchetypes[a].mask() == mask )
+		{
+			return a;
+		}
+	}
+
+	mArchetypes.push_back( archetype( mask ) );
+	return mArchetypes.size() - 1;
+}
+
+void circleSystem( entityworld &world, const brickfield &gameBricks, const brickgrid &grid, entity paddleEntity, int tickRate, taskpool *pool )
+{
+	TRACE_ZONE( "circleSystem" );
+
+	//The paddle, already moved this tick. A stale handle leaves the circles nothing to bounce off.
+	SimRect paddleBox = { 0, 0, 0, 0 };
+	const SimRect* solid = NULL;
+	int paddleVelX = 0;
+	const transform* at = world.get<transform>( paddleEntity );
+	const boxcollider* box = world.get<boxcollider>( paddleEntity );
+	const velocity* heading = world.get<velocity>( paddleEntity );
+	if( at != NULL && box != NULL )
+	{
+		SimRect placed = { at->x, at->y, box->w, box->h };
+		paddleBox = placed;
+		solid = &paddleBox;
+		paddleVelX = heading != NULL ? heading->x : 0;
+	}
+
+	world.each( COMPONENT_TRANSFORM | COMPONENT_VELOCITY | COMPONENT_CIRCLE | COMPONENT_CONTACTS, [&]( archetype &arch )
+	{
+		transform* t = arch.transforms.data();
+		velocity* v = arch.velocities.data();
+		const circlecollider* c = arch.circles.data();
+		contacts* hits = arch.contactLists.data();
+
+		std::function<void( int, int )> moveRange = [&]( int first, int last )
+		{
+			//Grid query scratch for this chunk, reused by each of its circles
+			std::vector<unsigned int> nearby;
+			nearby.reserve( 64 );
+
+			for( int i = first; i < last; i++ )
+			{
+				ballstate s = { t[i].x, t[i].y, v[i].x, v[i].y, v[i].remX, v[i].remY, c[i].r };
+				hits[i].paddle = sweepBall( s, gameBricks, grid, solid, paddleVelX, tickRate, nearby, hits[i].bricks, hits[i].sides, hits[i].count );
+
+				t[i].x = s.x;
+				t[i].y = s.y;
+				v[i].x = s.velX;
+				v[i].y = s.velY;
+				v[i].remX = s.remX;
+				v[i].remY = s.remY;
+			}
+		};
+
+		if( pool != NULL )
+		{
+			pool->parallelFor( arch.size(), circleGrain, moveRange );
+		}
+		else
+		{
+			moveRange( 0, arch.size() );
+		}
+	});
+}
@@ -0,0 +1,213 @@
+/*Archetype entity component system. Plain C++, no SDL.
+
+An entity is a handle to a set of components. Entities with the same set
+share an archetype, which keeps each of its components in an array of its
+own with the entities packed densely, row by row. Destroying an entity moves
+the archetype's last entity into its row, so the arrays never have holes.
+
+A system names the components it needs as a mask and walks the arrays of
+every archetype that has them, front to back, touching nothing else. Adding
+a new kind of thing, power-ups, debris, more balls, is a new set of
+components, not a new class and loop.
+
+Bricks are not entities. brickfield already keeps them the same way, split
+into dense arrays the batch collision kernel and grid read directly, with
+generation checked handles.*/
+
+#pragma once
+
+#include "BrickSim.h"
+#include "BrickTasks.h"
+#include <vector>
+
+//Position. Circles are placed by their centre, as the ball is, boxes by their top left corner, as the paddle is.
+struct transform
+{
+	int x, y;
+};
+
+//In pixels per reference tick, with the sub-pixel motion carried between ticks
+struct velocity
+{
+	int x, y;
+	int remX, remY;
+};
+
+struct circlecollider
+{
+	int r;
+};
+
+//An axis aligned box the circles bounce off
+struct boxcollider
+{
+	int w, h;
+};
+
+//Which sprite sheet, which frame of it, and where it is drawn from the entity's position
+enum spritesheet
+{
+	SHEET_BALL, SHEET_BRICK, SHEET_PADDLE
+};
+
+struct sprite
+{
+	spritesheet sheet;
+	int frame;
+	int offsetX, offsetY;
+};
+
+//What a moving circle ran into during its last move
+struct contacts
+{
+	int count;
+	bool paddle;
+	brickhandle bricks[ballMaxContacts];
+	brickside sides[ballMaxContacts];
+};
+
+//One bit per component, an archetype's mask has a bit for each component it holds
+enum componentbit
+{
+	COMPONENT_TRANSFORM = 1 << 0,
+	COMPONENT_VELOCITY = 1 << 1,
+	COMPONENT_CIRCLE = 1 << 2,
+	COMPONENT_SPRITE = 1 << 3,
+	COMPONENT_CONTACTS = 1 << 4,
+	COMPONENT_BOX = 1 << 5
+};
+
+//Names one entity for as long as it lives, stale once it is destroyed even if its id is reused
+struct entity
+{
+	unsigned int id;
+	unsigned int generation;
+};
+
+class archetype
+{
+public:
+	explicit archetype( unsigned int mask );
+
+	unsigned int mask() const;
+	int size() const;
+
+	//True if it holds every component in mask
+	bool has( unsigned int mask ) const;
+
+	//The entity in each row
+	std::vector<entity> entities;
+
+	//One array per component, empty for those the archetype doesn't hold
+	std::vector<transform> transforms;
+	std::vector<velocity> velocities;
+	std::vector<circlecollider> circles;
+	std::vector<sprite> sprites;
+	std::vector<contacts> contactLists;
+	std::vector<boxcollider> boxes;
+
+	//The array of component T, for code written once for any component
+	template<typename T> std::vector<T> &column();
+
+private:
+	friend class entityworld;
+
+	//Appends a row of zeroed components for e and returns it
+	int addRow( entity e );
+
+	//Moves the last row into row, returns the entity that moved or an entity with id -1 if none did
+	entity removeRow( int row );
+
+	unsigned int mMask;
+};
+
+template<> inline std::vector<transform> &archetype::column<transform>() { return transforms; }
+template<> inline std::vector<velocity> &archetype::column<velocity>() { return velocities; }
+template<> inline std::vector<circlecollider> &archetype::column<circlecollider>() { return circles; }
+template<> inline std::vector<sprite> &archetype::column<sprite>() { return sprites; }
+template<> inline std::vector<contacts> &archetype::column<contacts>() { return contactLists; }
+template<> inline std::vector<boxcollider> &archetype::column<boxcollider>() { return boxes; }
+
+class entityworld
+{
+public:
+	entityworld();
+
+	//Creates an entity holding the components in mask, all zeroed
+	entity create( unsigned int mask );
+
+	//Destroys the entity, the last one of its archetype takes its row. Returns false for a stale handle.
+	bool destroy( entity e );
+
+	//True while the entity has not been destroyed
+	bool alive( entity e ) const;
+
+	//The entity's component T, NULL for a stale handle or an entity without one
+	template<typename T> T* get( entity e )
+	{
+		if( !alive( e ) )
+		{
+			return NULL;
+		}
+		const entityrecord &record = mRecords[e.id];
+		std::vector<T> &column = mArchetypes[record.archetypeIndex].column<T>();
+		return column.empty() ? NULL : &column[record.row];
+	}
+
+	//Destroys every entity, archetypes keep their arrays' capacity
+	void clear();
+
+	//Live entities
+	int size() const;
+
+	//Calls fn( archetype& ) for each archetype holding every component in mask, in the order they were first made
+	template<typename F> void each( unsigned int mask, F fn )
+	{
+		for( size_t a = 0; a < mArchetypes.size(); a++ )
+		{
+			if( mArchetypes[a].has( mask ) && mArchetypes[a].size() > 0 )
+			{
+				fn( mArchetypes[a] );
+			}
+		}
+	}
+
+	//The same for systems that only read, calling fn( const archetype& )
+	template<typename F> void each( unsigned int mask, F fn ) const
+	{
+		for( size_t a = 0; a < mArchetypes.size(); a++ )
+		{
+			if( mArchetypes[a].has( mask ) && mArchetypes[a].size() > 0 )
+			{
+				fn( mArchetypes[a] );
+			}
+		}
+	}
+
+private:
+	//The archetype for mask, made on first use
+	int archetypeFor( unsigned int mask );
+
+	struct entityrecord
+	{
+		int archetypeIndex;
+		int row;
+		unsigned int generation;
+		bool alive;
+	};
+
+	std::vector<archetype> mArchetypes;
+	std::vector<entityrecord> mRecords;
+
+	//Ids waiting to be reused
+	std::vector<unsigned int> mFreeIds;
+
+	int mSize;
+};
+
+//Systems. Each walks only the archetypes with the components it names.
+
+//Moves every circle with a transform, velocity and contacts against the field and the paddle, an
+//entity with a transform, velocity and box, as ball::move moves the ball, and records what each
+//hit. The field is only read, so the circles are spread over pool's threads when one is given.
+void circleSystem( entityworld &world, const brickfield &gameBricks, const brickgrid &grid, entity paddleEntity, int tickRate, taskpool *pool );
@@ -0,0 +1,368 @@
+/*Endless mode: a brick field that scrolls down the screen forever.*/
+
+#include "BrickEndless.h"
+#include "BrickTrace.h"
+
+//Where the bottom of the first chunk starts, a little below where the classic field ends
+const int firstChunkBottom = 100;
+
+chunkstream::chunkstream()
+{
+	mQuit = false;
+	mSeed = 1;
+	mStalls = 0;
+
+	for( int i = 0; i < chunkPoolSize; i++ )
+	{
+		mFree.push( &mPool[i] );
+	}
+}
+
+chunkstream::~chunkstream()
+{
+	stop();
+}
+
+void chunkstream::start( unsigned int seed )
+{
+	stop();
+
+	//Chunks generated for the last run go back to the pool, no thread is running to race with
+	brickchunk* chunk;
+	while( mReady.pop( chunk ) )
+	{
+		mFree.push( chunk );
+	}
+
+	mQuit = false;
+	mSeed = seed;
+	mStalls = 0;
+	mThread = std::thread( &chunkstream::run, this );
+}
+
+void chunkstream::stop()
+{
+	if( !mThread.joinable() )
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( mLock );
+		mQuit = true;
+	}
+	mWakeGenerator.notify_one();
+	mThread.join();
+}
+
+brickchunk* chunkstream::take()
+{
+	brickchunk* chunk;
+	if( mReady.pop( chunk ) )
+	{
+		return chunk;
+	}
+
+	//The generator has fallen behind, the field waits rather than play a different game
+	TRACE_ZONE( "chunk stall" );
+	mStalls++;
+	std::unique_lock<std::mutex> lock( mLock );
+	while( !mReady.pop( chunk ) )
+	{
+		mWakeField.wait( lock );
+	}
+	return chunk;
+}
+
+void chunkstream::recycle( brickchunk* chunk )
+{
+	mFree.push( chunk );
+
+	//Taking the lock orders the push before the generator's check, so the wake can't be missed
+	{
+		std::lock_guard<std::mutex> lock( mLock );
+	}
+	mWakeGenerator.notify_one();
+}
+
+long long chunkstream::stalls() const
+{
+	return mStalls;
+}
+
+void chunkstream::run()
+{
+	for( long long index = 0; ; index++ )
+	{
+		brickchunk* chunk;
+		{
+			std::unique_lock<std::mutex> lock( mLock );
+			while( !mQuit && !mFree.pop( chunk ) )
+			{
+				mWakeGenerator.wait( lock );
+			}
+			if( mQuit )
+			{
+				return;
+			}
+		}
+
+		{
+			TRACE_ZONE( "generate chunk" );
+			generate( *chunk, index, mSeed );
+		}
+
+		mReady.push( chunk );
+		{
+			std::lock_guard<std::mutex> lock( mLock );
+		}
+		mWakeField.notify_one();
+	}
+}
+
+void chunkstream::generate( brickchunk &chunk, long long index, unsigned int seed )
+{
+	chunk.index = index;
+	chunk.top = 0;
+	chunk.count = 0;
+
+	//Each chunk has its own random sequence, so chunks can be made in any order
+	unsigned int random = (unsigned int)hashValue( hashValue( hashBasis, seed ), index );
+
+	//Further down the field bricks start taking more hits, up to three
+	int toughest = index < 16 ? 1 : index < 48 ? 2 : 3;
+
+	for( int row = 0; row < chunkRows; row++ )
+	{
+		//Rows are empty, full, checkered or scattered
+		random = random * 1664525u + 1013904223u;
+		int pattern = ( random >> 8 ) % 4;
+
+		for( int col = 0; col < chunkColumns; col++ )
+		{
+			random = random * 1664525u + 1013904223u;
+			bool place = pattern == 1 || ( pattern == 2 && ( row + col ) % 2 == 0 ) || ( pattern == 3 && ( random >> 20 ) % 3 != 0 );
+			if( !place )
+			{
+				continue;
+			}
+
+			int i = chunk.count++;
+			chunk.x[i] = col * brick::brick_width;
+			chunk.y[i] = row * brick::brick_height;
+			chunk.type[i] = ( random >> 8 ) % numBrickTypes;
+			chunk.hp[i] = 1 + ( random >> 12 ) % toughest;
+		}
+	}
+}
+
+endlessgame::endlessgame()
+{
+	seed = 1;
+	tickRate = referenceTickRate;
+	ballSpeed = ball::ball_VEL;
+	scrollSpeed = 20;
+	gamescore = 0;
+	gameOn = false;
+	chunksEntered = 0;
+	chunksRetired = 0;
+	bricksDestroyed = 0;
+	paddleHit = false;
+	mFirstLive = 0;
+	mLiveCount = 0;
+	mScrollRem = 0;
+}
+
+void endlessgame::reset()
+{
+	mainPaddle = paddle();
+	mainBall = ball();
+
+	//Every buffer has to be back in the pool before the stream restarts
+	while( mLiveCount > 0 )
+	{
+		mStream.recycle( mLive[mFirstLive] );
+		mFirstLive = ( mFirstLive + 1 ) % chunksOnField;
+		mLiveCount--;
+	}
+	mStream.start( seed );
+
+	gameBricks.clear();
+	chunksEntered = 0;
+	chunksRetired = 0;
+	mScrollRem = 0;
+
+	//The first chunk sits where the classic field does, the next one waits above the screen
+	scroll( 0 );
+
+	mainBall.place(SCREEN_WIDTH/2 - ball::ball_WIDTH/2, SCREEN_HEIGHT - SCOREBOARD_HEIGHT - paddle::paddle_height - ball::ball_HEIGHT/2);
+
+	gamescore = 0;
+	gameOn = false;
+	bricksDestroyed = 0;
+	paddleHit = false;
+	destroyed.clear();
+}
+
+void endlessgame::handleInput( gameinput input, bool pressed )
+{
+	mainPaddle.handleInput( input, pressed );
+	mainBall.handleInput( input, pressed, gameOn, ballSpeed );
+
+	if( pressed && input == INPUT_LAUNCH )
+	{
+		gameOn = true;
+	}
+}
+
+void endlessgame::step()
+{
+	moveObjects();
+	removeHit();
+}
+
+void endlessgame::moveObjects()
+{
+	//The field holds still until the ball is launched
+	if( gameOn )
+	{
+		mScrollRem += scrollSpeed;
+		int dy = mScrollRem / tickRate;
+		mScrollRem %= tickRate;
+		scroll( dy );
+	}
+
+	mainPaddle.move(tickRate);
+	paddleHit = mainBall.move(gameBricks, grid, mainPaddle, tickRate);
+}
+
+void endlessgame::removeHit()
+{
+	bricksDestroyed = 0;
+	destroyed.clear();
+
+	for(int h = 0; h < mainBall.mBricksHit.size(); h++)
+	{
+		brickhandle handle = mainBall.mBricksHit[h];
+		int i = gameBricks.indexOf(handle);
+		if(i < 0)
+		{
+			continue;
+		}
+
+		gameBricks.hit[i] = true;
+		gameBricks.sides[i] = mainBall.mSidesHit[h];
+
+		if(gameBricks.hitPoints[i] > 1)
+		{
+			gameBricks.hitPoints[i]--;
+			continue;
+		}
+
+		brickdestroyed gone = { handle, gameBricks.get(i) };
+		destroyed.push_back(gone);
+
+		grid.remove(handle.slot, gameBricks.rect(i));
+		gameBricks.removeAt(i);
+
+		gamescore++;
+		bricksDestroyed++;
+	}
+}
+
+unsigned long long endlessgame::stateHash() const
+{
+	unsigned long long hash = hashBasis;
+	hash = hashValue(hash, mainPaddle.mPosX);
+	hash = hashValue(hash, mainPaddle.mVelX);
+	hash = hashValue(hash, mainBall.mPosX);
+	hash = hashValue(hash, mainBall.mPosY);
+	hash = hashValue(hash, mainBall.getVelX());
+	hash = hashValue(hash, mainBall.getVelY());
+	for(int i = 0; i < gameBricks.size(); i++)
+	{
+		hash = hashValue(hash, gameBricks.xs()[i]);
+		hash = hashValue(hash, gameBricks.ys()[i]);
+		hash = hashValue(hash, gameBricks.hitPoints[i]);
+	}
+	hash = hashValue(hash, gamescore);
+	hash = hashValue(hash, gameOn);
+	hash = hashValue(hash, chunksEntered);
+	hash = hashValue(hash, chunksRetired);
+
+	return hash;
+}
+
+long long endlessgame::stalls() const
+{
+	return mStream.stalls();
+}
+
+void endlessgame::scroll( int dy )
+{
+	TRACE_ZONE( "scroll" );
+
+	gameBricks.translate(0, dy);
+	grid.translate(0, dy);
+	for(int c = 0; c < mLiveCount; c++)
+	{
+		mLive[(mFirstLive + c) % chunksOnField]->top += dy;
+	}
+
+	//Chunks leave once wholly below the play area, and a new one comes in while
+	//less than a chunk of bricks is waiting above the screen
+	bool changed = false;
+	while(mLiveCount > 0 && mLive[mFirstLive]->top >= SCREEN_HEIGHT - SCOREBOARD_HEIGHT)
+	{
+		retireChunk();
+		changed = true;
+	}
+
+	while(mLiveCount == 0 || mLive[(mFirstLive + mLiveCount - 1) % chunksOnField]->top > -chunkHeight)
+	{
+		int top = mLiveCount > 0 ? mLive[(mFirstLive + mLiveCount - 1) % chunksOnField]->top - chunkHeight : firstChunkBottom - chunkHeight;
+		enterChunk(top);
+		changed = true;
+	}
+
+	//The grid is sized to the field, so it is built again whenever chunks come or go
+	if(changed)
+	{
+		grid.build(gameBricks);
+	}
+}
+
+void endlessgame::enterChunk( int top )
+{
+	brickchunk* chunk = mStream.take();
+	chunk->top = top;
+
+	for(int i = 0; i < chunk->count; i++)
+	{
+		brick b;
+		b.arrange(chunk->x[i], top + chunk->y[i]);
+		b.bricktype = chunk->type[i];
+		b.hitpoints = chunk->hp[i];
+		chunk->handles[i] = gameBricks.add(b);
+	}
+
+	mLive[(mFirstLive + mLiveCount) % chunksOnField] = chunk;
+	mLiveCount++;
+	chunksEntered++;
+}
+
+void endlessgame::retireChunk()
+{
+	brickchunk* chunk = mLive[mFirstLive];
+
+	//Bricks still standing go without scoring, destroyed ones are already stale
+	for(int i = 0; i < chunk->count; i++)
+	{
+		gameBricks.remove(chunk->handles[i]);
+	}
+
+	mStream.recycle(chunk);
+	mFirstLive = (mFirstLive + 1) % chunksOnField;
+	mLiveCount--;
+	chunksRetired++;
+}
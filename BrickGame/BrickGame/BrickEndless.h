@@ -0,0 +1,176 @@
+/*Endless mode: a brick field that scrolls down the screen forever. Plain C++,
+no SDL.
+
+The field is made of chunks, bands of chunkRows rows of bricks across the
+screen. Chunks are generated on a thread of their own a few ahead of when
+they are needed. Each one enters the field above the top of the screen,
+scrolls down past the paddle and is retired once it has left the play area,
+its bricks taken off the field and its buffer handed back to the generator.
+
+Nothing grows with the length of a session. Chunk buffers come from a fixed
+pool, brick slots are reused by the field, and the field is moved rather than
+the view, so coordinates stay on screen however far it has scrolled. Moving
+it costs one add per brick each tick, for a field that never holds more than
+chunksOnField chunks.
+
+A chunk's bricks depend only on the seed and the chunk's number, never on
+when the generator got to it, so a seed always plays the same field.*/
+
+#pragma once
+
+#include "BrickSim.h"
+#include "BrickRing.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//Bricks across and rows down one chunk
+const int chunkColumns = SCREEN_WIDTH / brick::brick_width;
+const int chunkRows = 8;
+const int chunkCapacity = chunkColumns * chunkRows;
+const int chunkHeight = chunkRows * brick::brick_height;
+
+//Most chunks on the field at once: enough to cover the play area plus the
+//one above the screen and the one being entered above that
+const int chunksOnField = ( SCREEN_HEIGHT - SCOREBOARD_HEIGHT ) / chunkHeight + 4;
+
+//Chunks the generator keeps ready beyond those on the field
+const int chunksAhead = 4;
+
+//Chunk buffers in all, the field's plus those queued
+const int chunkPoolSize = chunksOnField + chunksAhead;
+
+struct brickchunk
+{
+	//Chunk number from the start of the game, and its top on screen while on the field
+	long long index;
+	int top;
+
+	//Bricks, placed relative to the chunk's top left
+	int count;
+	int x[chunkCapacity];
+	int y[chunkCapacity];
+	int type[chunkCapacity];
+	int hp[chunkCapacity];
+
+	//Handles of the bricks while on the field, stale once destroyed
+	brickhandle handles[chunkCapacity];
+};
+
+//Generates chunks in order on a thread of its own, into buffers from a fixed pool
+class chunkstream
+{
+public:
+	chunkstream();
+	~chunkstream();
+
+	//Starts generating from chunk 0, stopping any earlier run first.
+	//Every chunk taken must have been recycled.
+	void start( unsigned int seed );
+	void stop();
+
+	//The next chunk in order, waiting for the generator if it has fallen behind
+	brickchunk* take();
+
+	//Hands a retired chunk's buffer back to the generator
+	void recycle( brickchunk* chunk );
+
+	//Times take had to wait
+	long long stalls() const;
+
+	//Fills chunk with chunk number index of a game with seed
+	static void generate( brickchunk &chunk, long long index, unsigned int seed );
+
+private:
+	void run();
+
+	brickchunk mPool[chunkPoolSize];
+
+	//Buffers go round from free, to the generator, to ready, to the field and back to free
+	spscring<brickchunk*, 32> mFree;
+	spscring<brickchunk*, 32> mReady;
+
+	std::thread mThread;
+	std::mutex mLock;
+	std::condition_variable mWakeGenerator;
+	std::condition_variable mWakeField;
+	bool mQuit;
+
+	unsigned int mSeed;
+	long long mStalls;
+};
+
+//One ball and paddle under an endless scrolling field
+class endlessgame
+{
+public:
+	endlessgame();
+
+	//Lays out the first chunks from seed and puts paddle and ball at the start
+	void reset();
+
+	//Feeds a press or release to the paddle and ball
+	void handleInput( gameinput input, bool pressed );
+
+	//Advances the game by one tick, moving then removing
+	void step();
+
+	//The two halves of a tick: scroll the field and move the paddle and ball, then remove the bricks the ball hit
+	void moveObjects();
+	void removeHit();
+
+	//Hash of the paddle, ball, bricks, score and chunks, equal for equal states
+	unsigned long long stateHash() const;
+
+	//Times the field had to wait for a chunk
+	long long stalls() const;
+
+	//Picks the chunks, the same seed always gives the same field
+	unsigned int seed;
+
+	//Ticks per second of simulated time
+	int tickRate;
+
+	//Launch velocity of the ball on each axis, in pixels per reference tick
+	int ballSpeed;
+
+	//How fast the field comes down once the ball is launched, in pixels per second
+	int scrollSpeed;
+
+	paddle mainPaddle;
+	ball mainBall;
+	brickfield gameBricks;
+	brickgrid grid;
+
+	long long gamescore;
+	bool gameOn;
+
+	//Chunks that have entered and left the field
+	long long chunksEntered;
+	long long chunksRetired;
+
+	//What happened during the last step, so the caller can play sounds
+	int bricksDestroyed;
+	bool paddleHit;
+	std::vector<brickdestroyed> destroyed;
+
+private:
+	//Moves the field down by dy, retiring and entering chunks as it goes
+	void scroll( int dy );
+
+	//Takes the next chunk onto the field above the newest
+	void enterChunk( int top );
+
+	//Takes the oldest chunk off the field
+	void retireChunk();
+
+	chunkstream mStream;
+
+	//Chunks on the field, oldest and lowest first, in a ring
+	brickchunk* mLive[chunksOnField];
+	int mFirstLive;
+	int mLiveCount;
+
+	//Pixels per second carried over between ticks
+	int mScrollRem;
+};
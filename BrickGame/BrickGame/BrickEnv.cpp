@@ -0,0 +1,142 @@
+/*Batch environment for training paddle-control agents.*/
+
+#include "BrickEnv.h"
+
+//Games per chunk handed to a thread
+const int envGrain = 32;
+
+//Mixes value into a running seed hash
+static unsigned long long mixSeed( unsigned long long hash, unsigned long long value )
+{
+	hash = ( hash ^ value ) + 0x9E3779B97F4A7C15ULL;
+	hash = ( hash ^ ( hash >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+	hash = ( hash ^ ( hash >> 27 ) ) * 0x94D049BB133111EBULL;
+	return hash ^ ( hash >> 31 );
+}
+
+brickenv::brickenv( int numEnvs, int maxTicks, unsigned int seed )
+{
+	tickRate = referenceTickRate;
+	episodes = 0;
+	this->seed = seed;
+	mMaxTicks = maxTicks;
+
+	mGames.resize(numEnvs);
+	mTicks.resize(numEnvs);
+	mEpisodes.resize(numEnvs);
+	mObservations.resize(numEnvs);
+	mRewards.resize(numEnvs);
+	mDones.resize(numEnvs);
+
+	reset();
+}
+
+void brickenv::reset()
+{
+	for(int i = 0; i < mGames.size(); i++)
+	{
+		resetGame(i);
+		mRewards[i] = 0;
+		mDones[i] = 0;
+	}
+}
+
+void brickenv::step( const envaction* actions, taskpool &pool )
+{
+	pool.parallelFor(mGames.size(), envGrain, [this, actions]( int first, int last )
+	{
+		for(int i = first; i < last; i++)
+		{
+			brickgame &game = mGames[i];
+
+			//The action holds the paddle's direction for the whole tick
+			switch( actions[i] )
+			{
+				case ACTION_LEFT: game.mainPaddle.steer(-1); break;
+				case ACTION_RIGHT: game.mainPaddle.steer(1); break;
+				default: game.mainPaddle.steer(0); break;
+			}
+
+			game.step();
+			mTicks[i]++;
+
+			//One point for each brick, as on the scoreboard
+			mRewards[i] = (float)game.bricksDestroyed;
+			mDones[i] = game.cleared() || ( mMaxTicks > 0 && mTicks[i] >= mMaxTicks );
+
+			if( mDones[i] )
+			{
+				resetGame(i);
+			}
+			else
+			{
+				observe(i);
+			}
+		}
+	});
+
+	for(int i = 0; i < mDones.size(); i++)
+	{
+		episodes += mDones[i];
+	}
+}
+
+int brickenv::size() const
+{
+	return mGames.size();
+}
+
+const envobservation* brickenv::observations() const
+{
+	return mObservations.data();
+}
+
+const float* brickenv::rewards() const
+{
+	return mRewards.data();
+}
+
+const unsigned char* brickenv::dones() const
+{
+	return mDones.data();
+}
+
+unsigned int brickenv::gameSeed( int i ) const
+{
+	return mGames[i].seed;
+}
+
+void brickenv::resetGame( int i )
+{
+	brickgame &game = mGames[i];
+	game.seed = (unsigned int)( mixSeed(mixSeed(seed, i), mEpisodes[i]++) >> 32 );
+	game.reset();
+	game.tickRate = tickRate;
+	game.handleInput(INPUT_LAUNCH, true);
+	mTicks[i] = 0;
+
+	observe(i);
+}
+
+void brickenv::observe( int i )
+{
+	const brickgame &game = mGames[i];
+	envobservation &obs = mObservations[i];
+
+	obs.paddleX = (float)game.mainPaddle.mPosX;
+	obs.ballX = (float)game.mainBall.mPosX;
+	obs.ballY = (float)game.mainBall.mPosY;
+	obs.ballVelX = (float)game.mainBall.getVelX();
+	obs.ballVelY = (float)game.mainBall.getVelY();
+
+	//Slots are handed out in layout order and a brick keeps its slot until it is destroyed
+	obs.bricksLeft = 0;
+	for(int b = 0; b < game.gameBricks.size(); b++)
+	{
+		unsigned int slot = game.gameBricks.handleAt(b).slot;
+		if( slot < 64 )
+		{
+			obs.bricksLeft |= 1ULL << slot;
+		}
+	}
+}
@@ -0,0 +1,88 @@
+/*Batch environment for training paddle-control agents. Plain C++, no SDL.
+
+brickenv keeps N independent games side by side in one array and steps them
+all at once on a taskpool: the agent hands in one action per game and reads
+back one observation, reward and done flag per game from flat arrays.
+
+Each game is a brickgame stepped with brickgame::step, so the rules are
+exactly the ones the windowed game plays by. A game that finishes is laid out
+again straight away, and its observation is the first of the new episode.
+
+Every episode of every game gets its own field, seeded from the base seed,
+the game's index and how many episodes that game has had. The same base seed
+and actions give the same episodes on any number of threads.*/
+
+#pragma once
+
+#include "BrickSim.h"
+#include "BrickTasks.h"
+
+//What the agent can do with the paddle for one tick
+enum envaction
+{
+	ACTION_STAY, ACTION_LEFT, ACTION_RIGHT
+};
+
+//What the agent sees of one game, positions in pixels and velocities in pixels per reference tick
+struct envobservation
+{
+	float paddleX;
+	float ballX, ballY;
+	float ballVelX, ballVelY;
+
+	//Bit n is set while the brick laid out n-th is still standing
+	unsigned long long bricksLeft;
+};
+
+class brickenv
+{
+public:
+	//Creates numEnvs games laid out from seed. An episode ends when the field is cleared or,
+	//if maxTicks is above 0, after maxTicks ticks.
+	brickenv( int numEnvs, int maxTicks = 0, unsigned int seed = 1 );
+
+	//Starts a new episode in every game
+	void reset();
+
+	//Applies actions[i] to game i, steps every game by one tick on pool's threads
+	//and fills in the observations, rewards and done flags
+	void step( const envaction* actions, taskpool &pool );
+
+	int size() const;
+
+	//One entry per game, valid until the next step or reset
+	const envobservation* observations() const;
+	const float* rewards() const;
+	const unsigned char* dones() const;
+
+	//Seed game i's current episode was laid out from
+	unsigned int gameSeed( int i ) const;
+
+	//Ticks per second of simulated time in every game
+	int tickRate;
+
+	//Episodes finished so far, over all games
+	long long episodes;
+
+	//Base seed every episode's layout is derived from, takes effect at the next reset
+	unsigned int seed;
+
+private:
+	//Lays out game i afresh and launches its ball
+	void resetGame( int i );
+
+	//Copies what the agent sees of game i into its observation
+	void observe( int i );
+
+	int mMaxTicks;
+
+	std::vector<brickgame> mGames;
+	std::vector<int> mTicks;
+
+	//Episodes each game has started, picks its next seed
+	std::vector<long long> mEpisodes;
+
+	std::vector<envobservation> mObservations;
+	std::vector<float> mRewards;
+	std::vector<unsigned char> mDones;
+};
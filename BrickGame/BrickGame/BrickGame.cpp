@@ -7,84 +7,28 @@ and may not be redistributed without written permission.*/
 #include <SDL_ttf.h>
 #include <SDL_mixer.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 #include <string>
-#include <sstream>
 #include <vector>
 #include <array>
-
-//Screen dimension constants
-const int SCREEN_WIDTH = 800;
-const int SCREEN_HEIGHT = 800;
-
-//Score Board dimension
-const int SCOREBOARD_WIDTH = 800; 
-const int SCOREBOARD_HEIGHT = 200; 
-
-// Game globals
-const int numBrickTypes = 6; 
-const int numPaddleTypes = 6; 
-const int numBallTypes = 2; 
-const int numGameBricks = 36; 
-
-
-//Brick sides enum
-enum brickside
-{
-	NONE, TOP, RIGHT, BOTTOM, LEFT
-};
-
-//A circle stucture
-struct Circle
-{
-	int x, y;
-	int r;
-};
-
-//Texture wrapper class
-class LTexture
-{
-	public:
-		//Initializes variables
-		LTexture();
-
-		//Deallocates memory
-		~LTexture();
-
-		//Loads image at specified path
-		bool loadFromFile( std::string path );
-		
-		#ifdef _SDL_TTF_H
-		//Creates image from font string
-		bool loadFromRenderedText( std::string textureText, SDL_Color textColor );
-		#endif
-
-		//Deallocates texture
-		void free();
-
-		//Set color modulation
-		void setColor( Uint8 red, Uint8 green, Uint8 blue );
-
-		//Set blending
-		void setBlendMode( SDL_BlendMode blending );
-
-		//Set alpha modulation
-		void setAlpha( Uint8 alpha );
-		
-		//Renders texture at given point
-		void render( int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE );
-
-		//Gets image dimensions
-		int getWidth();
-		int getHeight();
-
-	private:
-		//The actual hardware texture
-		SDL_Texture* mTexture;
-
-		//Image dimensions
-		int mWidth;
-		int mHeight;
-};
+#include <thread>
+#include "BrickSim.h"
+#include "BrickText.h"
+#include "BrickSprites.h"
+#include "BrickAtlas.h"
+#include "BrickAssets.h"
+#include "BrickPack.h"
+#include "BrickAudio.h"
+#include "BrickMultiBall.h"
+#include "BrickRecord.h"
+#include "BrickProfile.h"
+#include "BrickTrace.h"
+#include "BrickLevel.h"
+#include "BrickEndless.h"
+#include "BrickParticles.h"
+#include "BrickInput.h"
+#include "BrickTexture.h"
 
 //The application time based timer
 class LTimer
@@ -118,154 +62,154 @@ class LTimer
 		bool mStarted;
 };
 
-class paddle
+class scoreboard 
 {
-    public:
-		//paddle dimensions
-		static const int paddle_width = 200;
-		static const int paddle_height = 24;
+public: 
+	
+	// variable to hold current fps
+	double avgFPS; 
 
-		//Maximum axis velocity of the paddle
-		static const int paddle_vel = 8;
+	scoreboard(); 
 
-		//Initializes the variables
-		paddle();
+	void render();
+}; 
 
-		//Takes key presses and adjusts the paddles velocity
-		void handleEvent( SDL_Event& e );
+//Reads the command line options into the globals below
+void parseArgs( int argc, char* args[] );
 
-		//Moves the paddle
-		void move();
+//Starts up SDL and creates window
+bool init();
 
-		//Shows the brick on the screen
-		void render();
+//Loads media, from the asset pack when there is a usable one
+bool loadMedia();
 
-		SDL_Rect mPaddleCollider;
+//The two ways of loading: mapping media/assets.pack, or decoding the files on worker threads
+bool loadPack();
+bool decodeMedia();
 
-		//The velocity of the paddle
-		int mVelX, mVelY;
+//Frees media and shuts down SDL
+void close();
 
-		//The X and Y offsets
-		int mPosX, mPosY;
+//Shows the game objects on the screen
+void renderPaddle( paddle& p );
+void renderBrick( const brick& b );
+void renderBall( ball& b );
 
-    private:
-		
-		void shiftColliders();
-};
+//Queues every entity with a transform and sprite
+void renderSprites( const entityworld& world );
 
-class brick
-{
-    public:
-		//Brick dimensions
-		static const int brick_width = 80;
-		static const int brick_height = 20;
-		bool hitbyball;
-		brickside sidehit;
-		int bricktype; 
+//Queues every live particle
+void renderParticles();
 
-		SDL_Rect brickRect;
+//Turns a key event into a simulation input, returns false for events the game ignores
+bool translateEvent( SDL_Event& e, gameinput& input, bool& pressed );
 
-		//Initializes the variables
-		brick();
+//Seconds from mark to now, moving mark on to now
+double lapSeconds( Uint64& mark );
 
-		//Shows the brick on the screen
-		void render();
+//Sleeps, then spins, until the performance counter reaches deadline
+void waitUntil( Uint64 deadline );
 
-		//Arrange brick in correct position
-		void arrange(int posX, int posY);
+//Draws the recent percentiles of every frame phase
+void renderProfile( int x, int y );
 
-    private:
-		//The X and Y offsets
-		int mPosX, mPosY;
-};
+//The window we'll be rendering to
+SDL_Window* gWindow = NULL;
 
-class ball
-{
-    public:
-		//The dimensions of the ball
-		static const int ball_WIDTH = 20;
-		static const int ball_HEIGHT = 20;
+//The window renderer
+SDL_Renderer* gRenderer = NULL;
 
-		//Maximum axis velocity of the ball
-		static const int ball_VEL = 6;
+//Physics ticks per second. 0 runs one tick per presented frame, which ties game speed to the display
+int gTickRate = 120;
 
-		//Initializes the variables
-		ball();
+//Most ticks simulated in one frame before the rest of a stall is dropped
+int gMaxSteps = 8;
 
-		//Takes key presses and adjusts the ball
-		void handleEvent( SDL_Event& e, bool gameOn);
+//Wait for vertical sync when presenting
+bool gVsync = true;
 
-		//Moves the ball
-		void move(std::vector<brick> &gameBricks, paddle &gamePaddle);
+//Wait out most of each frame, then read input, simulate and present just in time for the
+//next refresh. The margin, in milliseconds, is left spare for the frame's work to run long.
+bool gLateLatch = false;
+double gLatchMargin = 2.0;
 
-		//Shows the ball on the screen
-		void render();
+//Mixer buffer in sample frames, smaller is lower latency but needs the audio thread on time
+int gAudioBuffer = 2048;
 
-		// ball collision circle
-		Circle mBallCollider;
+//Mixer voices shared by every sound effect
+int gVoices = 8;
 
-		//The X and Y offsets of the ball
-		int mPosX, mPosY;
+//Map media/assets.pack at startup when it is there, instead of decoding the media files
+bool gUsePack = true;
 
-    private:
-		//The velocity of the ball
-		int mVelX, mVelY;
+//Draw the bricks from a cached layer texture instead of one sprite each
+bool gBrickLayerMode = false;
 
-		////Moves the collision circle relative to the balls offset
-		void shiftColliders();
-};
+//Balls in multi-ball mode, 0 plays the normal one ball game
+int gMultiBall = 0;
 
-class scoreboard 
-{
-public: 
-	
-	// variable to hold current fps
-	double avgFPS; 
+//Endless scrolling field instead of a level, and how fast it scrolls in pixels per second
+bool gEndless = false;
+int gScrollSpeed = 20;
 
-	// number of bricks cleared	
-	int gamescore; 
+//Debris and sparks from destroyed bricks
+bool gShowParticles = true;
 
-	scoreboard(); 
+//Read paddle input on a thread of its own, timestamped, with gamepads sampled this many times a second
+bool gInputThread = false;
+int gInputRate = 1000;
 
-	void render();
-}; 
+//Seed for the brick field, taken from the clock unless given
+unsigned int gSeed = 0;
+bool gSeedGiven = false;
 
-//Starts up SDL and creates window
-bool init();
+//Where to save a recording of the game's seed and inputs, NULL records nothing
+const char* gRecordPath = NULL;
 
-//Loads media
-bool loadMedia();
+//Level the one ball game is played on, the built in field if it won't load
+const char* gLevelPath = "media/levels/classic.txt";
+bricklevel gLevel;
 
-//Frees media and shuts down SDL
-void close();
+//Time spent in each part of the frame, the overlay is toggled with F3
+frameprofiler gProfiler;
+bool gShowProfile = false;
 
-//Circle/Box collision detector
-bool checkCollision( Circle& a, SDL_Rect& b );
+//Where the whole run's frame phase percentiles are written on exit
+const char* gProfilePath = "frametimes.csv";
 
-brickside checkCollisionSide(Circle& a, SDL_Rect& b);
+//Where trace zones are written, on exit and when F4 is pressed, in builds with BRICKGAME_TRACE
+const char* gTracePath = "trace.json";
 
-bool updateCollisionSide(Circle& a, brick& b);
+//Scene textures
+LTexture gDotTexture;
 
-//Calculates distance squared between two points
-double distanceSquared( int x1, int y1, int x2, int y2 );
+//Paddle, bricks, ball and scoreboard, packed into one texture by AtlasPacker
+LTexture gAtlasTexture;
+SDL_Color textColor = {41, 41, 41};
 
-//The window we'll be rendering to
-SDL_Window* gWindow = NULL;
+//Paddle, ball and bricks are queued here and drawn with one call per texture
+LSpriteBatch gSpriteBatch;
 
-//The window renderer
-SDL_Renderer* gRenderer = NULL;
+//The brick field kept in a render target, used when gBrickLayerMode is on
+LBrickLayer gBrickLayer;
 
-//Scene textures
-LTexture gDotTexture;
-LTexture gBrickTexture;
-LTexture gPaddleTexture;
-LTexture gBallTexture;
-LTexture gScoreBoardTexture; 
-LTexture gScoreTextHeaderTexture; 
-LTexture gFPSTextHeaderTexture;
-LTexture gScoreTextTexture; 
-LTexture gFPSTextTexture;
-SDL_Color textColor = {41, 41, 41};
+//Debris and sparks, moved once per drawn frame. Only for show, the random state is not the game's.
+particlepool gParticles;
+unsigned int gParticleRandom = 1;
+
+//Timestamped keyboard, mouse and gamepad input, used when gInputThread is on
+LInputSampler gInputSampler;
+
+//Plays the sound effects, the game loop only queues them
+LVoicePool gVoicePool;
+int gBrickHitVoice = -1;
+int gPaddleHitVoice = -1;
+
+//Pre-decoded images and sounds, mapped for as long as the game runs
+LAssetPack gAssetPack;
+
+//Every glyph of the HUD font in textColor, built once by loadMedia
+LGlyphAtlas gHudText;
 
 //Clips
 SDL_Rect gPaddleClips[numPaddleTypes]; 
@@ -273,6 +217,9 @@ SDL_Rect gBrickClips[numBrickTypes];
 SDL_Rect gBallClips[numBallTypes];
 SDL_Rect gScoreBoardClip; 
 
+//A chip from the middle of each brick sprite, then a speck of the ball for sparks
+SDL_Rect gParticleClips[particleSpark + 1];
+
 //Global Font
 TTF_Font *gFont = NULL; 
 
@@ -286,154 +233,6 @@ Mix_Chunk *gGameOverSound = NULL;
 Mix_Chunk *gGameWinSound = NULL; 
 
 
-LTexture::LTexture()
-{
-	//Initialize
-	mTexture = NULL;
-	mWidth = 0;
-	mHeight = 0;
-}
-
-LTexture::~LTexture()
-{
-	//Deallocate
-	free();
-}
-
-bool LTexture::loadFromFile( std::string path )
-{
-	//Get rid of preexisting texture
-	free();
-
-	//The final texture
-	SDL_Texture* newTexture = NULL;
-
-	//Load image at specified path
-	SDL_Surface* loadedSurface = IMG_Load( path.c_str() );
-	if( loadedSurface == NULL )
-	{
-		printf( "Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError() );
-	}
-	else
-	{
-		//Color key image
-		SDL_SetColorKey( loadedSurface, SDL_TRUE, SDL_MapRGB( loadedSurface->format, 0, 0xFF, 0xFF ) );
-
-		//Create texture from surface pixels
-        newTexture = SDL_CreateTextureFromSurface( gRenderer, loadedSurface );
-		if( newTexture == NULL )
-		{
-			printf( "Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError() );
-		}
-		else
-		{
-			//Get image dimensions
-			mWidth = loadedSurface->w;
-			mHeight = loadedSurface->h;
-		}
-
-		//Get rid of old loaded surface
-		SDL_FreeSurface( loadedSurface );
-	}
-
-	//Return success
-	mTexture = newTexture;
-	return mTexture != NULL;
-}
-
-#ifdef _SDL_TTF_H
-bool LTexture::loadFromRenderedText( std::string textureText, SDL_Color textColor )
-{
-	//Get rid of preexisting texture
-	free();
-
-	//Render text surface
-	SDL_Surface* textSurface = TTF_RenderText_Solid( gFont, textureText.c_str(), textColor );
-	if( textSurface != NULL )
-	{
-		//Create texture from surface pixels
-        mTexture = SDL_CreateTextureFromSurface( gRenderer, textSurface );
-		if( mTexture == NULL )
-		{
-			printf( "Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError() );
-		}
-		else
-		{
-			//Get image dimensions
-			mWidth = textSurface->w;
-			mHeight = textSurface->h;
-		}
-
-		//Get rid of old surface
-		SDL_FreeSurface( textSurface );
-	}
-	else
-	{
-		printf( "Unable to render text surface! SDL_ttf Error: %s\n", TTF_GetError() );
-	}
-
-	
-	//Return success
-	return mTexture != NULL;
-}
-#endif
-
-void LTexture::free()
-{
-	//Free texture if it exists
-	if( mTexture != NULL )
-	{
-		SDL_DestroyTexture( mTexture );
-		mTexture = NULL;
-		mWidth = 0;
-		mHeight = 0;
-	}
-}
-
-void LTexture::setColor( Uint8 red, Uint8 green, Uint8 blue )
-{
-	//Modulate texture rgb
-	SDL_SetTextureColorMod( mTexture, red, green, blue );
-}
-
-void LTexture::setBlendMode( SDL_BlendMode blending )
-{
-	//Set blending function
-	SDL_SetTextureBlendMode( mTexture, blending );
-}
-		
-void LTexture::setAlpha( Uint8 alpha )
-{
-	//Modulate texture alpha
-	SDL_SetTextureAlphaMod( mTexture, alpha );
-}
-
-void LTexture::render( int x, int y, SDL_Rect* clip, double angle, SDL_Point* center, SDL_RendererFlip flip )
-{
-	//Set rendering space and render to screen
-	SDL_Rect renderQuad = { x, y, mWidth, mHeight };
-
-	//Set clip rendering dimensions
-	if( clip != NULL )
-	{
-		renderQuad.w = clip->w;
-		renderQuad.h = clip->h;
-	}
-
-	//Render to screen
-	SDL_RenderCopyEx( gRenderer, mTexture, clip, &renderQuad, angle, center, flip );
-}
-
-int LTexture::getWidth()
-{
-	return mWidth;
-}
-
-int LTexture::getHeight()
-{
-	return mHeight;
-}
-
 LTimer::LTimer()
 {
     //Initialize the variables
@@ -536,299 +335,325 @@ bool LTimer::isPaused()
     return mPaused && mStarted;
 }
 
-paddle::paddle()
+void renderPaddle( paddle& p )
 {
-    //Initialize the paddle at the bottom middle
-	mPosX = SCREEN_WIDTH/2 - (paddle_width/2); // in the middle 
-	mPosY = SCREEN_HEIGHT - SCOREBOARD_HEIGHT - paddle_height; // bottom of the screen minus the height of the paddle
-
-    //Initialize the velocity
-    mVelX = 0;
-    mVelY = 0;
-
-	mPaddleCollider.h = paddle_height;
-	mPaddleCollider.w = paddle_width;
+    //Show the paddle
+	gSpriteBatch.add(gAtlasTexture.getTexture(), gPaddleClips[0], p.mPosX, p.mPosY);
 }
 
-void paddle::handleEvent( SDL_Event& e )
+void renderBrick( const brick& b )
 {
-    //If a key was pressed
-	if( e.type == SDL_KEYDOWN && e.key.repeat == 0 )
-    {
-        //Adjust the velocity
-        switch( e.key.keysym.sym )
-        {
-            //case SDLK_UP: mVelY -= paddle_vel; break;
-            //case SDLK_DOWN: mVelY += paddle_vel; break;
-            case SDLK_LEFT: mVelX -= paddle_vel; break;
-            case SDLK_RIGHT: mVelX += paddle_vel; break;
-        }
-    }
-    //If a key was released
-    else if( e.type == SDL_KEYUP && e.key.repeat == 0 )
-    {
-        //Adjust the velocity
-        switch( e.key.keysym.sym )
-        {
-           // case SDLK_UP: mVelY += paddle_vel; break;
-           // case SDLK_DOWN: mVelY -= paddle_vel; break;
-            case SDLK_LEFT: mVelX += paddle_vel; break;
-            case SDLK_RIGHT: mVelX -= paddle_vel; break;
-        }
-    }
+	gSpriteBatch.add(gAtlasTexture.getTexture(), gBrickClips[b.bricktype], b.brickRect.x, b.brickRect.y);
 }
 
-void paddle::move()
+void renderBall( ball& b )
 {
-    //Move the paddle left or right
-    mPosX += mVelX;
-	shiftColliders();
-
-    //If the paddle went too far to the left or right
-    if( ( mPosX < 0 ) || ( mPosX + paddle_width> SCREEN_WIDTH ) )
-    {
-        //Move back
-        mPosX -= mVelX;
-    }
+    //Show the ball
+	gSpriteBatch.add(gAtlasTexture.getTexture(), gBallClips[0], b.mPosX - b.mBallCollider.r, b.mPosY - b.mBallCollider.r);
 }
 
-void paddle::render()
+void renderSprites( const entityworld& world )
 {
-    //Show the paddle
-		gPaddleTexture.render(mPosX, mPosY, &gPaddleClips[0]);
+	world.each( COMPONENT_TRANSFORM | COMPONENT_SPRITE, []( const archetype& arch )
+	{
+		for( int i = 0; i < arch.size(); i++ )
+		{
+			const sprite& look = arch.sprites[i];
+			const SDL_Rect* clips = look.sheet == SHEET_BALL ? gBallClips : look.sheet == SHEET_BRICK ? gBrickClips : gPaddleClips;
+			gSpriteBatch.add( gAtlasTexture.getTexture(), clips[look.frame], arch.transforms[i].x + look.offsetX, arch.transforms[i].y + look.offsetY );
+		}
+	});
 }
 
-void paddle::shiftColliders() 
+void renderParticles()
 {
-	mPaddleCollider.x = mPosX; 
-	mPaddleCollider.y = mPosY; 
-}
+	const float* xs = gParticles.xs();
+	const float* ys = gParticles.ys();
+	const float* lives = gParticles.lives();
+	const unsigned int* colors = gParticles.colors();
+	const int* sprites = gParticles.sprites();
 
-brick::brick()
-{
-	mPosX = 0; 
-	mPosY = 0; 
-	brickRect.x = 0; 
-	brickRect.y = 0; 
-	brickRect.h = 0; 
-	brickRect.w = 0; 
-	sidehit = NONE; 
-	hitbyball = false;
-	bricktype = 0; 
-}
+	for( int i = 0; i < gParticles.size(); i++ )
+	{
+		//Fade out over the last quarter second
+		float fade = lives[i] < 0.25f ? lives[i] * 4.0f : 1.0f;
+		SDL_Color tint = { (Uint8)( colors[i] >> 24 ), (Uint8)( colors[i] >> 16 ), (Uint8)( colors[i] >> 8 ), (Uint8)( ( colors[i] & 0xFF ) * fade ) };
 
-void brick::render()
-{
-	gBrickTexture.render(mPosX, mPosY, &gBrickClips[bricktype]);
+		const SDL_Rect& clip = gParticleClips[sprites[i]];
+		gSpriteBatch.add( gAtlasTexture.getTexture(), clip, xs[i], ys[i], (float)clip.w, (float)clip.h, tint );
+	}
 }
 
-void brick::arrange(int posX, int posY)
+double lapSeconds( Uint64& mark )
 {
-	mPosX = posX; 
-	mPosY = posY;
-
-	brickRect.x = posX; 
-	brickRect.y = posY; 
-	brickRect.w = brick_width;
-	brickRect.h = brick_height;
+	Uint64 now = SDL_GetPerformanceCounter();
+	double seconds = (double)( now - mark ) / SDL_GetPerformanceFrequency();
+	mark = now;
+	return seconds;
 }
 
-ball::ball()
+void waitUntil( Uint64 deadline )
 {
-    //Initialize the offsets
-	mPosX = -200;
-	mPosY = -200; 
-
-	// Set collision circle size
-	mBallCollider.r = ball_WIDTH/2; 
-
-    //Initialize the velocity
-    mVelX = 0;
-    mVelY = 0;
-
-	//// move collider relative to the circle
-	shiftColliders();
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	for( Uint64 now = SDL_GetPerformanceCounter(); now < deadline; now = SDL_GetPerformanceCounter() )
+	{
+		//A sleep can run a millisecond or so over, so the last two are spun. Pumping as it
+		//goes lets the input sampler stamp keys and mouse motion when they come in.
+		if( ( deadline - now ) * 1000 > 2 * frequency )
+		{
+			SDL_PumpEvents();
+			SDL_Delay( 1 );
+		}
+	}
 }
 
-void ball::handleEvent( SDL_Event& e, bool gameOn )
+void renderProfile( int x, int y )
 {
-    //If a key was pressed
-	if( e.type == SDL_KEYDOWN && e.key.repeat == 0 && !gameOn )
-    {
-        //Adjust the velocity
-        switch( e.key.keysym.sym )
-        {
-            case SDLK_SPACE: 
-				{
-					mVelY -= ball_VEL; 
-					mVelX += ball_VEL;
-					break;
-				}
+	char line[128];
+	gHudText.render( gRenderer, x, y, "Last 1024 frames, ms     p50     p95     p99     max" );
 
-        }
-    }
+	for( int p = 0; p < numFramePhases; p++ )
+	{
+		const timehistogram& h = gProfiler.recent( (framephase)p );
+		snprintf( line, sizeof( line ), "%-8s %18.2f %7.2f %7.2f %7.2f", frameprofiler::phaseName( (framephase)p ),
+			h.percentile( 0.50 ) / 1000, h.percentile( 0.95 ) / 1000, h.percentile( 0.99 ) / 1000, h.max() / 1000 );
+		gHudText.render( gRenderer, x, y + ( p + 1 ) * 20, line );
+	}
+
+	//Input event to present, over the frames that had input
+	const timehistogram& h = gProfiler.recentLatency();
+	snprintf( line, sizeof( line ), "%-8s %18.2f %7.2f %7.2f %7.2f", "latency",
+		h.percentile( 0.50 ) / 1000, h.percentile( 0.95 ) / 1000, h.percentile( 0.99 ) / 1000, h.max() / 1000 );
+	gHudText.render( gRenderer, x, y + ( numFramePhases + 1 ) * 20, line );
 }
 
-void ball::move(std::vector<brick> &gameBricks, paddle &gamePaddle)
+bool translateEvent( SDL_Event& e, gameinput& input, bool& pressed )
 {
-    //Move the ball left or right
-    mPosX += mVelX;
-	shiftColliders();
-
-	//Move the ball up or down
-    mPosY += mVelY;
-	shiftColliders(); 
-
-    //Check left/right Screen Boundary collisions
-	if( (mPosX - mBallCollider.r < 0) || (mPosX + mBallCollider.r > SCREEN_WIDTH))
-	{
-        //Move ball back and invert x velocity to make it bounce
-        mPosX -= mVelX;
-		mVelX = mVelX*-1;
-		shiftColliders();
-    }
-
-	//Check up/down Screen Boundary collisions
-	if( ( mPosY - mBallCollider.r < 0 ) || ( mPosY + mBallCollider.r > SCREEN_HEIGHT))
-    {
-        //Invert Y velocity to make it bounce
-        mPosY -= mVelY;
-		mVelY = -1*mVelY;
-		shiftColliders();
-    }
-	
-	//Check for a brick collision
-	for(int c = 0; c < gameBricks.size(); c++)
+	//Only fresh presses and releases matter, not key repeats
+	if( ( e.type != SDL_KEYDOWN && e.type != SDL_KEYUP ) || e.key.repeat != 0 )
 	{
-		/* +opt - an optimization can be made here. We are checking every brick for collision but technically a ball could not collide with
-	       two bricks at the same time so we should break the evaluation whenever one collision occurs. */
-		if(checkCollision(mBallCollider, gameBricks[c].brickRect))
-		{
-		//collision with a brick, mark the brick as hit and on which side
-		//update the balls trajectory
-			gameBricks[c].hitbyball = true;
-			updateCollisionSide(mBallCollider, gameBricks[c]);
-
-			switch (gameBricks[c].sidehit)
-			{
-				case TOP:
-					{
-						mPosY -= mVelY;
-						mVelY = -1*mVelY;
-						shiftColliders();
-						break;
-					}
-				case BOTTOM:
-					{
-						mPosY -= mVelY;
-						mVelY = -1*mVelY;
-						shiftColliders();
-						break;
-					}
-
-				case RIGHT:
-					{
-						mPosX -= mVelX;
-						mVelX = mVelX*-1;
-						shiftColliders();
-						break;
-					}
-				case LEFT:
-					{
-						mPosX -= mVelX;
-						mVelX = mVelX*-1;
-						shiftColliders();
-						break;
-					}
-			}
-		}
+		return false;
 	}
 
-	//check for collision with paddle
-	if(checkCollision(mBallCollider, gamePaddle.mPaddleCollider))
+	switch( e.key.keysym.sym )
 	{
-		//change ball velocity based on paddles velocity
-		mVelX = mVelX + gamePaddle.mVelX/4; 
-
-		//invert y to bounce
-		mPosY -= mVelY;
-		mVelY = -1*mVelY;
-
-		//update balls collider
-		shiftColliders();
-
-		Mix_PlayChannel(-1, gPaddleHitSound, 0); 
-
+		case SDLK_LEFT: input = INPUT_LEFT; break;
+		case SDLK_RIGHT: input = INPUT_RIGHT; break;
+		case SDLK_SPACE: input = INPUT_LAUNCH; break;
+		default: return false;
 	}
-}
 
-void ball::render()
-{
-    //Show the ball
-	gBallTexture.render( mPosX - mBallCollider.r, mPosY - mBallCollider.r, &gBallClips[0] );
-}
-
-void ball::shiftColliders()
-{
-	mBallCollider.x = mPosX; 
-	mBallCollider.y = mPosY; 
+	pressed = e.type == SDL_KEYDOWN;
+	return true;
 }
 
 scoreboard::scoreboard()
 {
-	int fps = 0; 
-	int gamescore = 0; 
+	avgFPS = 0; 
 }
 
 void scoreboard::render()
 {
-	gScoreBoardTexture.render(0, 0, &gScoreBoardClip); 
+	gSpriteBatch.add(gAtlasTexture.getTexture(), gScoreBoardClip, 0, 0); 
 }
 
-bool init()
+void parseArgs( int argc, char* args[] )
 {
-	//Initialization flag
-	bool success = true;
-
-	//Initialize SDL
-	if( SDL_Init( SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0 )
-	{
-		printf( "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
-		success = false;
-	}
-	else
+	for( int i = 1; i < argc; i++ )
 	{
-		//Set texture filtering to linear
-		if( !SDL_SetHint( SDL_HINT_RENDER_SCALE_QUALITY, "1" ) )
+		std::string arg = args[i];
+
+		if( arg == "--tickrate" && i + 1 < argc )
 		{
-			printf( "Warning: Linear texture filtering not enabled!" );
+			gTickRate = atoi( args[++i] );
 		}
-
-		//Create window
-		gWindow = SDL_CreateWindow( "SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-		if( gWindow == NULL )
+		else if( arg == "--maxsteps" && i + 1 < argc )
 		{
-			printf( "Window could not be created! SDL Error: %s\n", SDL_GetError() );
-			success = false;
+			gMaxSteps = atoi( args[++i] );
 		}
-		else
+		else if( arg == "--novsync" )
 		{
-			//Create vsynced renderer for window
-			gRenderer = SDL_CreateRenderer( gWindow, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC );
-			if( gRenderer == NULL )
-			{
-				printf( "Renderer could not be created! SDL Error: %s\n", SDL_GetError() );
-				success = false;
-			}
-			else
-			{
-				//Initialize renderer color
-				SDL_SetRenderDrawColor(gRenderer, 195, 195, 195, 0xFF);
-
-				//Initialize PNG loading
-				int imgFlags = IMG_INIT_PNG;
-				if( !( IMG_Init( imgFlags ) & imgFlags ) )
-				{
+			gVsync = false;
+		}
+		else if( arg == "--latelatch" )
+		{
+			gLateLatch = true;
+		}
+		else if( arg == "--latchmargin" && i + 1 < argc )
+		{
+			gLateLatch = true;
+			gLatchMargin = atof( args[++i] );
+		}
+		else if( arg == "--bricklayer" )
+		{
+			gBrickLayerMode = true;
+		}
+		else if( arg == "--nopack" )
+		{
+			gUsePack = false;
+		}
+		else if( arg == "--lowlatency" )
+		{
+			gAudioBuffer = 256;
+		}
+		else if( arg == "--audiobuffer" && i + 1 < argc )
+		{
+			gAudioBuffer = atoi( args[++i] );
+		}
+		else if( arg == "--voices" && i + 1 < argc )
+		{
+			gVoices = atoi( args[++i] );
+		}
+		else if( arg == "--multiball" && i + 1 < argc )
+		{
+			gMultiBall = atoi( args[++i] );
+		}
+		else if( arg == "--endless" )
+		{
+			gEndless = true;
+		}
+		else if( arg == "--scroll" && i + 1 < argc )
+		{
+			gScrollSpeed = atoi( args[++i] );
+		}
+		else if( arg == "--inputthread" )
+		{
+			//Keyboard and mouse are only stamped as events are pumped, which the late latch wait does every millisecond
+			gInputThread = true;
+			gLateLatch = true;
+		}
+		else if( arg == "--inputrate" && i + 1 < argc )
+		{
+			gInputThread = true;
+			gLateLatch = true;
+			gInputRate = atoi( args[++i] );
+		}
+		else if( arg == "--noparticles" )
+		{
+			gShowParticles = false;
+		}
+		else if( arg == "--seed" && i + 1 < argc )
+		{
+			gSeed = (unsigned int)strtoul( args[++i], NULL, 10 );
+			gSeedGiven = true;
+		}
+		else if( arg == "--record" && i + 1 < argc )
+		{
+			gRecordPath = args[++i];
+		}
+		else if( arg == "--level" && i + 1 < argc )
+		{
+			gLevelPath = args[++i];
+		}
+		else if( arg == "--profile" )
+		{
+			gShowProfile = true;
+		}
+		else if( arg == "--profilecsv" && i + 1 < argc )
+		{
+			gProfilePath = args[++i];
+		}
+		else if( arg == "--trace" && i + 1 < argc )
+		{
+			gTracePath = args[++i];
+		}
+		else
+		{
+			printf( "Unknown option %s\n", args[i] );
+		}
+	}
+
+	if( gTickRate < 0 )
+	{
+		gTickRate = 0;
+	}
+
+	if( gMaxSteps < 1 )
+	{
+		gMaxSteps = 1;
+	}
+
+	if( gAudioBuffer < 64 )
+	{
+		gAudioBuffer = 64;
+	}
+
+	if( gVoices < 1 )
+	{
+		gVoices = 1;
+	}
+
+	if( gMultiBall < 0 )
+	{
+		gMultiBall = 0;
+	}
+
+	if( gScrollSpeed < 0 )
+	{
+		gScrollSpeed = 0;
+	}
+
+	if( !gSeedGiven )
+	{
+		gSeed = (unsigned int)time( NULL );
+	}
+}
+
+bool init()
+{
+	TRACE_ZONE( "init" );
+
+	//Initialization flag
+	bool success = true;
+
+	//Initialize SDL
+	if( SDL_Init( SDL_INIT_VIDEO | SDL_INIT_AUDIO | ( gInputThread ? SDL_INIT_GAMECONTROLLER : 0 ) ) < 0 )
+	{
+		printf( "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
+		success = false;
+	}
+	else
+	{
+		//Set texture filtering to linear
+		if( !SDL_SetHint( SDL_HINT_RENDER_SCALE_QUALITY, "1" ) )
+		{
+			printf( "Warning: Linear texture filtering not enabled!" );
+		}
+
+		//Create window
+		gWindow = SDL_CreateWindow( "SDL Tutorial", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+		if( gWindow == NULL )
+		{
+			printf( "Window could not be created! SDL Error: %s\n", SDL_GetError() );
+			success = false;
+		}
+		else
+		{
+			//Create renderer for window, vsynced unless turned off
+			Uint32 rendererFlags = SDL_RENDERER_ACCELERATED;
+			if( gVsync )
+			{
+				rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+			}
+			if( gBrickLayerMode )
+			{
+				rendererFlags |= SDL_RENDERER_TARGETTEXTURE;
+			}
+			gRenderer = SDL_CreateRenderer( gWindow, -1, rendererFlags );
+			if( gRenderer == NULL )
+			{
+				printf( "Renderer could not be created! SDL Error: %s\n", SDL_GetError() );
+				success = false;
+			}
+			else
+			{
+				//Initialize renderer color
+				SDL_SetRenderDrawColor(gRenderer, 195, 195, 195, 0xFF);
+
+				//Initialize PNG loading
+				int imgFlags = IMG_INIT_PNG;
+				if( !( IMG_Init( imgFlags ) & imgFlags ) )
+				{
 					printf( "SDL_image could not initialize! SDL_image Error: %s\n", IMG_GetError() );
 					success = false;
 				}
@@ -841,7 +666,7 @@ bool init()
                 }
 
 				 //Initialize SDL_mixer
-                if( Mix_OpenAudio( 44100, MIX_DEFAULT_FORMAT, 2, 2048 ) < 0 )
+                if( Mix_OpenAudio( mixerFrequency, mixerFormat, mixerChannels, gAudioBuffer ) < 0 )
                 {
                     printf( "SDL_mixer could not initialize! SDL_mixer Error: %s\n", Mix_GetError() );
                     success = false;
@@ -853,85 +678,196 @@ bool init()
 	return success;
 }
 
-bool loadMedia()
+bool loadHudFont( void* data )
 {
-	//Loading success flag
-	bool success = true;
+	gFont = TTF_OpenFont( "media/alterebro.ttf", 28);  
 
-	//Load paddle, brick, ball texture
-	if( !gPaddleTexture.loadFromFile( "media/paddlesspritesheet.png" ) | !gBrickTexture.loadFromFile("media/bricksspritesheet.png")
-		| !gBallTexture.loadFromFile("media/ballsspritesheet.png"))
+	if(gFont == NULL)
 	{
-		printf( "Failed to load paddle, ball, brick sprite texture!\n" );
-		success = false;
+		printf( "Failed to load lazy font! SDL_ttf Error: %s\n", TTF_GetError() );
+		return false;
 	}
-	else
+
+	//The glyphs are rasterized here too, loadMedia only uploads them
+	if( !gHudText.rasterize( gFont, textColor ) )
 	{
-		gPaddleClips[0].x = 0; 
-		gPaddleClips[0].y = 0; 
-		gPaddleClips[0].w = 200; 
-		gPaddleClips[0].h = 24; 	
+		printf( "Failed to build HUD glyph atlas!\n" );
+		return false;
+	}
+
+	return true;
+}
 
+void renderLoadingScreen( LAssetLoader& loader )
+{
+	bool quitRequested = false;
 
-		for(int r = 0; r < numBrickTypes; r++)
+	while( !loader.finished() )
+	{
+		//Keep the window responsive, a quit is handed on to the main loop
+		SDL_Event e;
+		while( SDL_PollEvent( &e ) != 0 )
 		{
-			gBrickClips[r].x = 0; 
-			gBrickClips[r].y = r*20; 
-			gBrickClips[r].w = 80;
-			gBrickClips[r].h = 20; 
+			if( e.type == SDL_QUIT )
+			{
+				quitRequested = true;
+			}
+		}
+
+		SDL_SetRenderDrawColor( gRenderer, 195, 195, 195, 0xFF );
+		SDL_RenderClear( gRenderer );
+
+		//A bar across the middle of the screen fills as assets finish
+		SDL_Rect outline = { SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 - 10, SCREEN_WIDTH / 2, 20 };
+		SDL_Rect fill = outline;
+		fill.w = outline.w * loader.getDone() / loader.getTotal();
+
+		SDL_SetRenderDrawColor( gRenderer, textColor.r, textColor.g, textColor.b, 0xFF );
+		SDL_RenderFillRect( gRenderer, &fill );
+		SDL_RenderDrawRect( gRenderer, &outline );
+
+		SDL_RenderPresent( gRenderer );
 
+		//Without vsync, don't spin a core the workers could use
+		if( !gVsync )
+		{
+			SDL_Delay( 10 );
 		}
+	}
 
-		// Load Ball
-		gBallClips[0].x = 0; 
-		gBallClips[0].y = 0; 
-		gBallClips[0].w = 20;
-		gBallClips[0].h = 20; 
-		
+	if( quitRequested )
+	{
+		SDL_Event quitEvent;
+		quitEvent.type = SDL_QUIT;
+		SDL_PushEvent( &quitEvent );
 	}
+}
+
+bool loadMedia()
+{
+	TRACE_ZONE( "loadMedia" );
+
+	Uint32 startTicks = SDL_GetTicks();
 
-	//load scoreboard textures
-	if(!gScoreBoardTexture.loadFromFile( "media/scoreboard.png" ))
+	bool success;
+	if( gUsePack && loadPack() )
 	{
-		printf( "Failed to load score board texture!\n" );
-		success = false;
+		//The font is not in the pack, it is rasterized here
+		success = loadHudFont( NULL ) && gHudText.upload( gRenderer );
+		printf( "Loaded assets from media/assets.pack in %u ms\n", SDL_GetTicks() - startTicks );
 	}
 	else
 	{
-		gScoreBoardClip.x = 0; 
-		gScoreBoardClip.y = 0; 
-		gScoreBoardClip.h = SCOREBOARD_HEIGHT; 
-		gScoreBoardClip.w = SCOREBOARD_WIDTH; 		
+		success = decodeMedia();
 	}
-	
-	gFont = TTF_OpenFont( "media/alterebro.ttf", 28);  
 
-	if(gFont == NULL)
+	//Sprite clips come from the generated atlas table
+	gPaddleClips[0] = atlasClips[ATLAS_PADDLE]; 
+
+	for(int r = 0; r < numBrickTypes; r++)
 	{
-		printf( "Failed to load lazy font! SDL_ttf Error: %s\n", TTF_GetError() );
-        success = false;
+		gBrickClips[r] = atlasClips[ATLAS_BRICK0 + r]; 
+	}
+
+	gBallClips[0] = atlasClips[ATLAS_BALL]; 
+	gScoreBoardClip = atlasClips[ATLAS_SCOREBOARD]; 
+
+	for(int r = 0; r <= particleSpark; r++)
+	{
+		const SDL_Rect& sheet = r < numBrickTypes ? gBrickClips[r] : gBallClips[0];
+		int size = r < numBrickTypes ? 4 : 3;
+		SDL_Rect chip = { sheet.x + sheet.w / 2 - size / 2, sheet.y + sheet.h / 2 - size / 2, size, size };
+		gParticleClips[r] = chip;
+	}
+
+	//Paddle hits outrank brick hits, and only a few copies of one sound play at once
+	if( success )
+	{
+		gPaddleHitVoice = gVoicePool.addSound( gPaddleHitSound, 2, 2 );
+		gBrickHitVoice = gVoicePool.addSound( gBrickHitSound, 1, 3 );
+
+		if( !gVoicePool.start( gVoices ) )
+		{
+			printf( "Failed to start the voice pool!\n" );
+			success = false;
+		}
+	}
+
+	return success;
+}
+
+bool loadPack()
+{
+	TRACE_ZONE( "loadPack" );
+
+	if( !gAssetPack.open( "media/assets.pack" ) )
+	{
+		return false;
+	}
+
+	//Textures and chunks are made straight from the mapped bytes
+	bool success = gAtlasTexture.loadFromTexture( gAssetPack.createTexture( gRenderer, "atlas.png" ) );
+	gBrickHitSound = gAssetPack.createChunk( "brickhitsound.wav" );
+	gPaddleHitSound = gAssetPack.createChunk( "paddlehitsound.wav" );
+
+	if( !success || gBrickHitSound == NULL || gPaddleHitSound == NULL )
+	{
+		printf( "Asset pack is incomplete, decoding the media files instead\n" );
+
+		gAtlasTexture.free();
+		Mix_FreeChunk( gBrickHitSound );
+		Mix_FreeChunk( gPaddleHitSound );
+		gBrickHitSound = NULL;
+		gPaddleHitSound = NULL;
+		gAssetPack.close();
+		return false;
 	}
-	else 
+
+	return true;
+}
+
+bool decodeMedia()
+{
+	TRACE_ZONE( "decodeMedia" );
+
+	//Loading success flag
+	bool success = true;
+
+	Uint32 startTicks = SDL_GetTicks();
+
+	//Decode everything on worker threads, the slowest jobs first
+	SDL_Surface* atlasSurface = NULL;
+
+	LAssetLoader loader;
+	loader.addJob( loadHudFont, NULL );
+	loader.addImage( "media/atlas.png", &atlasSurface );
+	loader.addSound( "media/brickhitsound.wav", &gBrickHitSound );
+	loader.addSound( "media/paddlehitsound.wav", &gPaddleHitSound );
+	loader.start();
+
+	renderLoadingScreen( loader );
+
+	if( !loader.wait() )
 	{
-		gScoreTextHeaderTexture.loadFromRenderedText("Score: ", textColor); 
-		gFPSTextHeaderTexture.loadFromRenderedText("FPS: ", textColor); 
+		success = false;
 	}
 
-	// Sound FX
-	gBrickHitSound = Mix_LoadWAV("media/brickhitsound.wav");
-	if(gBrickHitSound == NULL)
+	//Only the texture uploads happen on the render thread
+	if( atlasSurface == NULL || !gAtlasTexture.loadFromSurface( atlasSurface ) )
 	{
-		printf("Failed to load brickhit sound. Error: %s\n", Mix_GetError());
-		success = false; 
+		printf( "Failed to load sprite atlas texture!\n" );
+		success = false;
 	}
+	SDL_FreeSurface( atlasSurface );
 
-	gPaddleHitSound = Mix_LoadWAV("media/paddlehitsound.wav");
-	if(gPaddleHitSound == NULL)
+	if( gFont != NULL && !gHudText.upload( gRenderer ) )
 	{
-		printf("Failed to load paddle hit sound. Error: %s\n", Mix_GetError());
-		success = false; 
+		printf( "Failed to upload HUD glyph atlas!\n" );
+		success = false;
 	}
 
+	printf( "Loaded %d assets on %d worker threads in %u ms\n", loader.getTotal(), loader.getWorkers(), SDL_GetTicks() - startTicks );
+
 	return success;
 }
 
@@ -939,8 +875,12 @@ void close()
 {
 	//Free loaded images
 	gDotTexture.free();
-	gBallTexture.free();
-	gPaddleTexture.free();
+	gAtlasTexture.free();
+
+	//No voice may be playing a chunk while it is freed
+	printf( "Sounds played: %d, on stolen voices: %d, dropped: %d\n", gVoicePool.getPlayed(), gVoicePool.getStolen(), gVoicePool.getDropped() );
+	gVoicePool.stop();
+	gInputSampler.stop();
 
 	//Free Sound FX
 	Mix_FreeChunk(gBrickHitSound);
@@ -948,7 +888,14 @@ void close()
 	Mix_FreeChunk(gGameOverSound);
 	Mix_FreeChunk(gGameWinSound); 
 
+	//Sounds from the pack play its mapped bytes, so it goes after them
+	gAssetPack.close();
+
+	//Free the brick layer
+	gBrickLayer.free();
+
 	//Free global font
+	gHudText.free();
 	TTF_CloseFont(gFont); 
 
 	//Destroy window	
@@ -964,105 +911,10 @@ void close()
 	SDL_Quit();
 }
 
-bool checkCollision( Circle& a, SDL_Rect& b)
-{
-    //Closest point on collision box
-    int cX, cY = 0;
-
-    //Find closest x offset
-    if( a.x < b.x )
-    {
-        cX = b.x;
-    }
-    else if( a.x > b.x + b.w )
-    {
-        cX = b.x + b.w;
-    }
-    else
-    {
-        cX = a.x;
-    }
-
-    //Find closest y offset
-    if( a.y < b.y )
-    {
-        cY = b.y;
-    }
-    else if( a.y > b.y + b.h )
-    {
-        cY = b.y + b.h;
-    }
-    else
-    {
-        cY = a.y;
-    }
-
-    //If the closest point is inside the circle
-    if( distanceSquared( a.x, a.y, cX, cY ) < a.r * a.r )
-    {
-        //This box and the circle have collided
-        return true;
-    }
-
-    //If the shapes have not collided
-    return false;
-}
-
-// Updates the brick.sidehit with the side that was hit. Return of true is success, return of false is that no side was hit
-bool updateCollisionSide(Circle& a, brick& b)
-{
-	if(a.x < b.brickRect.x) // ball is to the left of the brick
-	{	
-		if(a.y < b.brickRect.y - b.brickRect.h/2) // ball is above the brick
-		{
-			//This is a top hit
-			b.sidehit = TOP; return true; 
-		}
-		else if (a.y > b.brickRect.y + b.brickRect.h/2) // ball is below the brick
-		{
-			//This is a bottom hit
-			b.sidehit = BOTTOM; return true; 
-		}
-
-		else
-		{
-			//Ball is neither below or above the brick. This is a left hit
-			b.sidehit = LEFT; return true; 
-		}
-	}
-
-	if(a.x > b.brickRect.x) // ball is to the right of the brick
-	{
-		if(a.y < b.brickRect.y - b.brickRect.h/2) // ball is above the brick
-		{
-			//This is a top hit
-			b.sidehit = TOP; return true; 
-		}
-		else if (a.y > b.brickRect.y + b.brickRect.h/2) // ball is below the brick
-		{
-			//This is a bottom hit
-			b.sidehit = BOTTOM; return true; 
-		}
-
-		else
-		{
-			//Ball is neither below or above the brick. This is a left hit
-			b.sidehit = RIGHT; return true; 
-		}
-
-		return false; 
-	}
-}
-
-double distanceSquared( int x1, int y1, int x2, int y2 )
-{
-	int deltaX = x2 - x1;
-	int deltaY = y2 - y1;
-	return deltaX*deltaX + deltaY*deltaY;
-}
-
 int main( int argc, char* args[] )
 {
+	parseArgs( argc, args );
+
 	//Start up SDL and create window
 	if( !init() )
 	{
@@ -1086,9 +938,11 @@ int main( int argc, char* args[] )
 			// frames per second timer
 			LTimer fpsTimer; 
 
-			// in memory text stream
-			std::stringstream fpsTimeText; 
-			std::stringstream scoreText; 
+			// HUD text, formatted in place every frame
+			char fpsTimeText[32]; 
+			char scoreText[32]; 
+			char drawCallText[64]; 
+			char layerText[64]; 
 			
 			int countedFrames = 0; 
 			fpsTimer.start(); 
@@ -1097,14 +951,91 @@ int main( int argc, char* args[] )
 
 			
 
-			// Maintain list of bricks in the game
-			const int brickcount = 6; 
-
-			// instantiate game objects
-			paddle mainPaddle;
+			// instantiate game objects, the paddle, ball, bricks and score live in the simulation
+			brickgame game;
 			
-			//Create the playing field with numGameBricks, arrange them and make them random types. 
-			std::vector<brick> gameBricks(numGameBricks);
+			//Physics runs at a fixed rate, frames render as fast as the display allows
+			fixedstep stepper( gTickRate > 0 ? gTickRate : referenceTickRate, gMaxSteps );
+			game.tickRate = stepper.tickRate();
+			game.seed = gSeed;
+			if( gLevel.load( gLevelPath ) )
+			{
+				game.level = &gLevel;
+			}
+			else
+			{
+				printf( "Playing the built in field instead\n" );
+			}
+			game.reset();
+
+			//Only the one ball game is recorded, BrickReplay plays it back without a window
+			replaylog recording;
+			bool recordingOn = gRecordPath != NULL && gMultiBall == 0 && !gEndless && !gInputThread;
+			if( recordingOn )
+			{
+				recording.begin( game );
+				recording.level = game.level != NULL ? gLevelPath : "";
+			}
+			else if( gRecordPath != NULL )
+			{
+				printf( "Only the one ball game on a level with tick timed input can be recorded, not recording\n" );
+			}
+
+			//Multi-ball mode plays on its own field, with the balls moved on every core
+			multiballgame* swarm = NULL;
+			taskpool* swarmPool = NULL;
+			if( gMultiBall > 0 )
+			{
+				swarm = new multiballgame( gMultiBall );
+				swarm->tickRate = stepper.tickRate();
+
+				int threads = std::thread::hardware_concurrency();
+				swarmPool = new taskpool( threads > 0 ? threads : 1 );
+			}
+
+			//Endless mode streams its field in chunks, generated on a thread of their own.
+			//Its rings are cache line aligned, which new doesn't promise before C++17, so it lives here.
+			endlessgame endlessGame;
+			endlessgame* endless = NULL;
+			if( gEndless && !swarm )
+			{
+				endless = &endlessGame;
+				endless->tickRate = stepper.tickRate();
+				endless->seed = gSeed;
+				endless->scrollSpeed = gScrollSpeed;
+				endless->reset();
+
+				//The whole field moves every tick, a cached layer would be drawn again every frame
+				gBrickLayerMode = false;
+			}
+
+			//Whichever game is running, for the code the two modes share
+			paddle& activePaddle = swarm ? swarm->mainPaddle : endless ? endless->mainPaddle : game.mainPaddle;
+			ball& activeBall = endless ? endless->mainBall : game.mainBall;
+			brickfield& activeBricks = swarm ? swarm->gameBricks : endless ? endless->gameBricks : game.gameBricks;
+			brickgrid& activeGrid = swarm ? swarm->grid : endless ? endless->grid : game.grid;
+			std::vector<brickdestroyed>& activeDestroyed = swarm ? swarm->destroyed : endless ? endless->destroyed : game.destroyed;
+			Uint64 lastCounter = SDL_GetPerformanceCounter();
+
+			//How long the display shows a frame, late latching aims its work at the end of it
+			double frameInterval = 1.0 / 60;
+			SDL_DisplayMode displayMode;
+			if( SDL_GetCurrentDisplayMode( SDL_GetWindowDisplayIndex( gWindow ), &displayMode ) == 0 && displayMode.refresh_rate > 0 )
+			{
+				frameInterval = 1.0 / displayMode.refresh_rate;
+			}
+
+			//When the last present returned, with vsync about when the last refresh began
+			Uint64 lastPresent = lastCounter;
+
+			//Paddle input goes through the sampler when it starts, the event loop only sees the rest
+			bool sampling = gInputThread && gInputSampler.start( gInputRate );
+			double tickCounts = (double)SDL_GetPerformanceFrequency() / stepper.tickRate();
+
+			//Positions before the last tick, rendering blends from these to the current ones
+			int prevPaddleX = activePaddle.mPosX;
+			int prevBallX = activeBall.mPosX;
+			int prevBallY = activeBall.mPosY;
 
 			SDL_Rect mainGameViewport; 
 			mainGameViewport.x = 0; 
@@ -1119,41 +1050,49 @@ int main( int argc, char* args[] )
 			ScoreBoardViewport.w = SCREEN_WIDTH; 
 			ScoreBoardViewport.h = SCOREBOARD_HEIGHT; 
 
-			for(int i = 0; i < gameBricks.size(); i++)
-			{
-				gameBricks[i].bricktype = rand() % 6; 
-
-				if(i < 9)
-				{
-					gameBricks[i].arrange(80*i+40, 20);
-				}
-				else if (i >= 9 && i < 18)
-				{
-					gameBricks[i].arrange(80*(i-9)+40, 40);
-				}
-				else if (i >= 18 && i < 27)
-				{
-					gameBricks[i].arrange(80*(i-18)+40, 60); 
-				}
-				else
-				{
-					gameBricks[i].arrange(80*(i-27)+40, 80); 				
-				}
-			}
-
-			ball mainBall;
 			scoreboard mainScoreboard; 
-			mainScoreboard.gamescore = 0; 
 
-			mainBall.mPosX = SCREEN_WIDTH/2 - mainBall.ball_WIDTH/2; 
-			mainBall.mPosY = SCREEN_HEIGHT - SCOREBOARD_HEIGHT - mainPaddle.paddle_height - mainBall.ball_HEIGHT/2; 
+			//Without target texture support the bricks go through the sprite batch as usual
+			if( gBrickLayerMode && !gBrickLayer.create( gRenderer, mainGameViewport.w, mainGameViewport.h ) )
+			{
+				gBrickLayerMode = false;
+			}
 
-			// Game has started?
-			bool gameOn = false; 
+			//The layer is drawn in full before its first use and whenever its contents are lost
+			bool brickLayerDirty = true;
 
 			//While application is running
 			while( !quit )
 			{
+				//Each phase is timed from where the last one ended
+				Uint64 frameStart = SDL_GetPerformanceCounter();
+				Uint64 phaseMark = frameStart;
+				TRACE_ZONE( "frame" );
+
+				if( gLateLatch )
+				{
+					TRACE_ZONE( "latch wait" );
+
+					//Start as long before the next refresh as the frame's work has recently taken, plus the margin
+					double work = 0;
+					for( int p = PHASE_EVENTS; p <= PHASE_HUD; p++ )
+					{
+						work += gProfiler.recent( (framephase)p ).percentile( 0.95 ) / 1000000;
+					}
+					double wait = frameInterval - work - gLatchMargin / 1000;
+					if( wait > 0 )
+					{
+						waitUntil( lastPresent + (Uint64)( wait * SDL_GetPerformanceFrequency() ) );
+					}
+				}
+
+				gProfiler.add( PHASE_WAIT, lapSeconds( phaseMark ) );
+				TRACE_BEGIN( eventsZone, "events" );
+
+				//Oldest input event this frame, for its latency once presented. SDL stamps events in milliseconds.
+				bool inputThisFrame = false;
+				Uint32 firstInputTicks = 0;
+
 				//Handle events on queue
 				while( SDL_PollEvent( &e ) != 0 )
 				{
@@ -1163,60 +1102,239 @@ int main( int argc, char* args[] )
 						quit = true;
 					}
 
-					//Handle input for the paddle
-					mainPaddle.handleEvent( e );
+					//Some renderers throw away target texture contents, e.g. on a Direct3D device reset
+					if( e.type == SDL_RENDER_TARGETS_RESET )
+					{
+						brickLayerDirty = true;
+					}
 
-					//Handle input for the paddle
-					mainBall.handleEvent( e, gameOn);
+					if( e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3 && e.key.repeat == 0 )
+					{
+						gShowProfile = !gShowProfile;
+					}
+
+					#ifdef BRICKGAME_TRACE
+					if( e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F4 && e.key.repeat == 0 && traceBuffer().writeJSON( gTracePath ) )
+					{
+						printf( "Trace written to %s\n", gTracePath );
+					}
+					#endif
 
-					// Once the user presses space to start the game, set gameOn to prevent any further presses of "space" to change velocity.
-					if(e.type = SDL_KEYDOWN)
+					//Handle input for the paddle and ball
+					gameinput input;
+					bool pressed;
+					if( translateEvent( e, input, pressed ) )
 					{
-						switch( e.key.keysym.sym )
+						if( !inputThisFrame || e.key.timestamp < firstInputTicks )
+						{
+							firstInputTicks = e.key.timestamp;
+						}
+						inputThisFrame = true;
+
+						if( sampling )
+						{
+							//Already stamped by the sampler, it reaches the game at its time within a tick
+						}
+						else if( swarm )
+						{
+							swarm->mainPaddle.handleInput( input, pressed );
+						}
+						else if( endless )
 						{
-							case SDLK_SPACE: 
-								{
-									gameOn = true;
-								}
+							endless->handleInput( input, pressed );
+						}
+						else
+						{
+							if( recordingOn )
+							{
+								recording.input( input, pressed );
+							}
+							game.handleInput( input, pressed );
 						}
 					}
 				}
 
+				gProfiler.add( PHASE_EVENTS, lapSeconds( phaseMark ) );
+				TRACE_END( eventsZone );
+
 				//Clear screen
 				SDL_SetRenderDrawColor( gRenderer, 195, 195, 195, 0xFF );
 				SDL_RenderClear( gRenderer );
 
-				//Move the paddle
-				mainPaddle.move();
-				mainBall.move(gameBricks, mainPaddle);
+				//Work out how many ticks are due since the last frame
+				Uint64 counter = SDL_GetPerformanceCounter();
+				double frameSeconds = (double)( counter - lastCounter ) / SDL_GetPerformanceFrequency();
+				Uint64 previousCounter = lastCounter;
+				lastCounter = counter;
 
-				//Remove destroyed blocks if they exist
-				for(int i = 0; i < gameBricks.size(); i++)
+				int steps = gTickRate > 0 ? stepper.advance( frameSeconds ) : 1;
+				double alpha = gTickRate > 0 ? stepper.alpha() : 1.0;
+
+				gProfiler.add( PHASE_SETUP, lapSeconds( phaseMark ) );
+
+				for( int step = 0; step < steps; step++ )
 				{
-					if(gameBricks[i].hitbyball == true)
+					prevPaddleX = activePaddle.mPosX;
+					prevBallX = activeBall.mPosX;
+					prevBallY = activeBall.mPosY;
+					TRACE_BEGIN( moveZone, "move" );
+
+					if( sampling )
+					{
+						//This tick ends alpha ticks and the ticks still to run before now. Ticking once
+						//per frame, it covers the frame.
+						Uint64 tickEnd = counter - (Uint64)( gTickRate > 0 ? ( alpha + steps - 1 - step ) * tickCounts : 0 );
+						Uint64 tickStart = gTickRate > 0 ? tickEnd - (Uint64)tickCounts : previousCounter;
+						if( gInputSampler.feedTick( tickStart, tickEnd, activePaddle ) )
+						{
+							if( endless )
+							{
+								endless->handleInput( INPUT_LAUNCH, true );
+							}
+							else if( !swarm )
+							{
+								game.handleInput( INPUT_LAUNCH, true );
+							}
+						}
+					}
+
+					//Move the paddle and ball
+					if( swarm )
+					{
+						swarm->moveBalls( *swarmPool );
+					}
+					else if( endless )
+					{
+						endless->moveObjects();
+					}
+					else
+					{
+						game.moveObjects();
+					}
+
+					gProfiler.add( PHASE_MOVE, lapSeconds( phaseMark ) );
+					TRACE_END( moveZone );
+					TRACE_BEGIN( removeZone, "remove" );
+
+					//Remove destroyed blocks
+					bool paddleHit;
+					if( swarm )
+					{
+						int fieldsCleared = swarm->fieldsCleared;
+						swarm->removeHit();
+						paddleHit = swarm->paddleHits > 0;
+
+						//A cleared field is laid out again in full
+						if( swarm->fieldsCleared != fieldsCleared )
+						{
+							brickLayerDirty = true;
+						}
+					}
+					else if( endless )
 					{
-						gameBricks.erase(gameBricks.begin() + i);
-						mainScoreboard.gamescore++; 
-						Mix_PlayChannel(-1, gBrickHitSound, 0); 
+						endless->removeHit();
+						paddleHit = endless->paddleHit;
+					}
+					else
+					{
+						game.removeHit();
+						paddleHit = game.paddleHit;
+
+						if( recordingOn )
+						{
+							recording.ticked( game );
+						}
+					}
+
+					if( paddleHit )
+					{
+						gVoicePool.play(gPaddleHitVoice); 
+					}
+
+					for(int i = 0; i < activeDestroyed.size(); i++)
+					{
+						gVoicePool.play(gBrickHitVoice); 
+
+						if( gShowParticles )
+						{
+							spawnBrickBurst(gParticles, activeDestroyed[i].b, gParticleRandom);
+						}
+
+						//Only the destroyed brick's rect of the layer changes
+						if( gBrickLayerMode && !brickLayerDirty )
+						{
+							gBrickLayer.erase(gRenderer, activeDestroyed[i].b.brickRect, activeBricks, activeGrid, gAtlasTexture.getTexture(), gBrickClips);
+						}
 					}
+
+					gProfiler.add( PHASE_REMOVE, lapSeconds( phaseMark ) );
+					TRACE_END( removeZone );
 				}
 
+				//Particles move with the frame, however many ticks it held
+				gParticles.update( (float)frameSeconds );
+				gProfiler.add( PHASE_MOVE, lapSeconds( phaseMark ) );
+
 				// Switch to the main game viewport and render all objects
+				TRACE_BEGIN( renderZone, "render" );
 				SDL_RenderSetViewport(gRenderer, &mainGameViewport); 
 
 				//Arrange and Render bricks
-				for(brick b: gameBricks)
+				if( gBrickLayerMode )
+				{
+					if( brickLayerDirty )
+					{
+						gBrickLayer.rebuild(gRenderer, activeBricks, gAtlasTexture.getTexture(), gBrickClips);
+						brickLayerDirty = false;
+
+						//Drawing into the layer reset the viewport
+						SDL_RenderSetViewport(gRenderer, &mainGameViewport); 
+					}
+					gBrickLayer.render(gRenderer, 0, 0);
+				}
+				else
+				{
+					for(int i = 0; i < activeBricks.size(); i++)
+					{
+						renderBrick(activeBricks.get(i)); 
+					}
+				}
+
+				//Queued brick sprites are drawn by the flush below and count as render
+				gProfiler.add( PHASE_BRICKS, lapSeconds( phaseMark ) );
+
+				//Draw the moving objects part way between their last two ticks
+				paddle drawPaddle = activePaddle;
+				drawPaddle.mPosX = prevPaddleX + (int)( ( activePaddle.mPosX - prevPaddleX ) * alpha );
+				renderPaddle(drawPaddle); 
+
+				if( swarm )
+				{
+					//Thousands of balls are drawn where the last tick left them
+					renderSprites(swarm->world);
+				}
+				else
 				{
-					b.render(); 
+					ball drawBall = activeBall;
+					drawBall.mPosX = prevBallX + (int)( ( activeBall.mPosX - prevBallX ) * alpha );
+					drawBall.mPosY = prevBallY + (int)( ( activeBall.mPosY - prevBallY ) * alpha );
+					renderBall(drawBall);
 				}
 
-				mainPaddle.render(); 
-				mainBall.render();
+				renderParticles();
+
+				//Submit the queued sprites while the game viewport is still set
+				gSpriteBatch.flush(gRenderer);
+
+				gProfiler.add( PHASE_RENDER, lapSeconds( phaseMark ) );
+				TRACE_END( renderZone );
+				TRACE_BEGIN( hudZone, "hud" );
 				
 				// Switch to the scoreboard viewport and update the scoreboard
 				SDL_RenderSetViewport(gRenderer, &ScoreBoardViewport);
 
 				mainScoreboard.render(); 
+				gSpriteBatch.flush(gRenderer);
 
 				avgFPS = countedFrames / (fpsTimer.getTicks() / 1000.f);
 
@@ -1225,25 +1343,81 @@ int main( int argc, char* args[] )
 					avgFPS = 0; 
 				}
 
-				fpsTimeText.str("");
-				fpsTimeText << avgFPS; 
+				snprintf(fpsTimeText, sizeof(fpsTimeText), "%g", avgFPS); 
+				gHudText.render(gRenderer, 64 + 36, 128, fpsTimeText); 
+
+				snprintf(scoreText, sizeof(scoreText), "%lld", swarm ? swarm->gamescore : endless ? endless->gamescore : (long long)game.gamescore); 
+				gHudText.render(gRenderer, 64 + 52, 64, scoreText);
+
+				gHudText.render(gRenderer, 64, 128, "FPS: ");
+				gHudText.render(gRenderer, 64, 64, "Score: ");
 
-				gFPSTextTexture.loadFromRenderedText(fpsTimeText.str().c_str(), textColor);
-				gFPSTextTexture.render(64 + 36, 128); 
+				//How much sprite batching is saving this frame
+				snprintf(drawCallText, sizeof(drawCallText), "Draw calls: %d  saved: %d", gSpriteBatch.getDrawCalls(), gSpriteBatch.getDrawCallsSaved()); 
+				gHudText.render(gRenderer, 400, 64, drawCallText);
+				gSpriteBatch.resetStats();
+
+				//Bricks drawn into the layer this frame, zero unless one was just destroyed
+				if( gBrickLayerMode )
+				{
+					snprintf(layerText, sizeof(layerText), "Layer bricks redrawn: %d", gBrickLayer.getBricksDrawn()); 
+					gHudText.render(gRenderer, 400, 128, layerText);
+					gBrickLayer.resetStats();
+				}
 
-				scoreText.str("");
-				scoreText << mainScoreboard.gamescore; 
-				gScoreTextTexture.loadFromRenderedText(scoreText.str().c_str(), textColor);
-				gScoreTextTexture.render(64 + 52, 64);
+				//Where the frame time goes, drawn over the open space below the bricks
+				if( gShowProfile )
+				{
+					SDL_RenderSetViewport(gRenderer, &mainGameViewport); 
+					renderProfile( 16, 320 );
+				}
 
-				gFPSTextHeaderTexture.render(64, 128);
-				gScoreTextHeaderTexture.render(64, 64);
+				gProfiler.add( PHASE_HUD, lapSeconds( phaseMark ) );
+				TRACE_END( hudZone );
 				
 				//Update screen
+				TRACE_BEGIN( presentZone, "present" );
 				SDL_RenderPresent( gRenderer );
+				lastPresent = SDL_GetPerformanceCounter();
+				if( inputThisFrame )
+				{
+					gProfiler.addLatency( ( SDL_GetTicks() - firstInputTicks ) / 1000.0 );
+				}
+
+				gProfiler.add( PHASE_PRESENT, lapSeconds( phaseMark ) );
+				TRACE_END( presentZone );
+				gProfiler.add( PHASE_FRAME, lapSeconds( frameStart ) );
+				gProfiler.endFrame();
 
 				++countedFrames;
 			}
+
+			if( gProfiler.writeCSV( gProfilePath ) )
+			{
+				printf( "Frame phase times written to %s\n", gProfilePath );
+			}
+
+			const timehistogram& latency = gProfiler.totalLatency();
+			if( latency.count() > 0 )
+			{
+				printf( "Input to present over %lld frames with input: p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.1f ms\n", latency.count(),
+					latency.percentile( 0.50 ) / 1000, latency.percentile( 0.95 ) / 1000, latency.percentile( 0.99 ) / 1000, latency.max() / 1000 );
+			}
+
+			#ifdef BRICKGAME_TRACE
+			if( traceBuffer().writeJSON( gTracePath ) )
+			{
+				printf( "Trace written to %s\n", gTracePath );
+			}
+			#endif
+
+			if( recordingOn && recording.save( gRecordPath ) )
+			{
+				printf( "Recorded %lld ticks with seed %u to %s\n", recording.ticks, recording.seed, gRecordPath );
+			}
+
+			delete swarmPool;
+			delete swarm;
 		}
 	}
 
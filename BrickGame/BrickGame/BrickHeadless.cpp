@@ -0,0 +1,163 @@
+/*Headless BrickGame driver. Steps the simulation core as fast as it can,
+with a simple bot on the paddle, and reports simulated ticks per second.
+
+Usage: BrickHeadless [ticks] [tickrate] [bricks] [speed]
+
+bricks pads the field out to that many bricks by stacking extra rows above
+the top of the screen, out of the ball's reach. Play is unchanged but the
+collision pass has a large field to look through.
+
+speed is the ball's launch velocity per axis in pixels per 60 Hz tick. With a
+low tick rate and a high speed the ball covers many pixels per tick, the
+report counts ticks that ended with the ball's centre inside a brick.*/
+
+#include "BrickSim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+//Stacks rows of unreachable bricks above the screen until the field holds count bricks
+void padField(brickgame &game, int count)
+{
+	int perRow = SCREEN_WIDTH / brick::brick_width;
+	for(int i = 0; game.gameBricks.size() < count; i++)
+	{
+		brick b;
+		b.arrange((i % perRow) * brick::brick_width, -brick::brick_height * (i / perRow + 2));
+		game.gameBricks.add(b);
+	}
+	game.grid.build(game.gameBricks);
+}
+
+//Keeps the paddle under the ball by pressing and releasing left/right
+class paddlebot
+{
+public:
+	paddlebot()
+	{
+		mHeld = 0;
+	}
+
+	void update(brickgame &game)
+	{
+		int paddleCentre = game.mainPaddle.mPosX + paddle::paddle_width/2;
+		int wanted = 0;
+
+		if(game.mainBall.mPosX < paddleCentre - paddle::paddle_width/4)
+		{
+			wanted = -1;
+		}
+		else if(game.mainBall.mPosX > paddleCentre + paddle::paddle_width/4)
+		{
+			wanted = 1;
+		}
+
+		if(wanted != mHeld)
+		{
+			//Let go of whatever was held, then press the new direction
+			if(mHeld != 0)
+			{
+				game.handleInput(mHeld < 0 ? INPUT_LEFT : INPUT_RIGHT, false);
+			}
+			if(wanted != 0)
+			{
+				game.handleInput(wanted < 0 ? INPUT_LEFT : INPUT_RIGHT, true);
+			}
+			mHeld = wanted;
+		}
+	}
+
+	void reset()
+	{
+		mHeld = 0;
+	}
+
+private:
+	//-1 left held, 1 right held, 0 nothing held
+	int mHeld;
+};
+
+int main( int argc, char* args[] )
+{
+	long long ticks = 10000000;
+	if(argc > 1)
+	{
+		ticks = atoll(args[1]);
+	}
+
+	brickgame game;
+	if(argc > 2)
+	{
+		game.tickRate = atoi(args[2]);
+	}
+
+	int bricks = numGameBricks;
+	if(argc > 3)
+	{
+		bricks = atoi(args[3]);
+		padField(game, bricks);
+	}
+
+	if(argc > 4)
+	{
+		game.ballSpeed = atoi(args[4]);
+	}
+
+	paddlebot bot;
+	game.handleInput(INPUT_LAUNCH, true);
+
+	long long games = 1;
+	long long destroyed = 0;
+	long long inside = 0;
+
+	//Time spent laying out new fields, kept out of the per tick figure
+	double resetSeconds = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for(long long t = 0; t < ticks; t++)
+	{
+		bot.update(game);
+		game.step();
+		destroyed += game.bricksDestroyed;
+
+		//A ball that tunnelled into a brick ends up with its centre in it
+		SimRect centre = { game.mainBall.mPosX, game.mainBall.mPosY, 0, 0 };
+		const std::vector<unsigned int> &nearby = game.grid.query(centre);
+		for(int n = 0; n < nearby.size(); n++)
+		{
+			SimRect r = game.gameBricks.rect(game.gameBricks.indexOfSlot(nearby[n]));
+			if(centre.x > r.x && centre.x < r.x + r.w && centre.y > r.y && centre.y < r.y + r.h)
+			{
+				inside++;
+				break;
+			}
+		}
+
+		//Start a new session once the reachable bricks are cleared
+		if(game.gamescore == numGameBricks)
+		{
+			std::chrono::steady_clock::time_point resetStart = std::chrono::steady_clock::now();
+			game.reset();
+			padField(game, bricks);
+			resetSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - resetStart).count();
+			bot.reset();
+			game.handleInput(INPUT_LAUNCH, true);
+			games++;
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("ticks: %lld\n", ticks);
+	printf("tick rate: %d\n", game.tickRate);
+	printf("games: %lld\n", games);
+	printf("bricks in field: %d\n", bricks);
+	printf("bricks destroyed: %lld\n", destroyed);
+	printf("ticks ending inside a brick: %lld\n", inside);
+	printf("seconds: %.3f\n", seconds);
+	printf("reset seconds: %.3f\n", resetSeconds);
+	printf("ticks/s: %.0f\n", seconds > resetSeconds ? ticks / (seconds - resetSeconds) : 0.0);
+
+	return 0;
+}
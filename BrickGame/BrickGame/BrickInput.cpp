@@ -0,0 +1,309 @@
+/*Timestamped paddle input.*/
+
+#include "BrickInput.h"
+#include <stdio.h>
+#include <algorithm>
+
+//Stick travel ignored around the centre, out of 32767
+const int stickDeadZone = 8000;
+
+//Smallest stick change worth queuing
+const float stickStep = 1.0f / 64;
+
+//Orders inputs oldest first
+static bool inputBefore( const timedinput& a, const timedinput& b )
+{
+	return a.time < b.time;
+}
+
+LInputSampler::LInputSampler()
+{
+	//Initialize
+	mThread = NULL;
+	SDL_AtomicSet( &mQuit, 0 );
+	SDL_AtomicSet( &mDropped, 0 );
+	mRate = 1000;
+	mWatching = false;
+	mNumPads = 0;
+	mAttached = -1;
+	mLastAxis = 0;
+	mLastLeft = false;
+	mLastRight = false;
+	mLastLaunch = false;
+}
+
+LInputSampler::~LInputSampler()
+{
+	//Stop the sampling thread
+	stop();
+}
+
+bool LInputSampler::start( int rate )
+{
+	//Get rid of a running sampler
+	stop();
+
+	mRate = rate > 0 ? rate : 1000;
+	mPending.clear();
+
+	//The sampling thread updates the pads itself, the event pump must not race it to
+	SDL_GameControllerEventState( SDL_IGNORE );
+	SDL_JoystickEventState( SDL_IGNORE );
+
+	SDL_AtomicSet( &mQuit, 0 );
+	mThread = SDL_CreateThread( run, "InputSampler", this );
+	if( mThread == NULL )
+	{
+		printf( "Unable to start input thread! SDL Error: %s\n", SDL_GetError() );
+		return false;
+	}
+
+	SDL_AddEventWatch( watch, this );
+	mWatching = true;
+
+	if( SDL_SetRelativeMouseMode( SDL_TRUE ) < 0 )
+	{
+		printf( "Relative mouse mode not available, the mouse won't move the paddle! SDL Error: %s\n", SDL_GetError() );
+	}
+
+	return true;
+}
+
+void LInputSampler::stop()
+{
+	if( mWatching )
+	{
+		SDL_DelEventWatch( watch, this );
+		SDL_SetRelativeMouseMode( SDL_FALSE );
+		mWatching = false;
+	}
+
+	if( mThread != NULL )
+	{
+		SDL_AtomicSet( &mQuit, 1 );
+		SDL_WaitThread( mThread, NULL );
+		mThread = NULL;
+
+		//Drain what the thread left behind
+		timedinput in;
+		while( mPadInputs.pop( in ) )
+		{
+		}
+		while( mEventInputs.pop( in ) )
+		{
+		}
+	}
+}
+
+bool LInputSampler::feedTick( Uint64 start, Uint64 end, paddle& p )
+{
+	//Each ring is in time order on its own, merged they need sorting
+	size_t before = mPending.size();
+	timedinput in;
+	while( mEventInputs.pop( in ) )
+	{
+		mPending.push_back( in );
+	}
+	while( mPadInputs.pop( in ) )
+	{
+		mPending.push_back( in );
+	}
+	if( mPending.size() != before )
+	{
+		std::stable_sort( mPending.begin(), mPending.end(), inputBefore );
+	}
+
+	bool launched = false;
+	size_t used = 0;
+	for( ; used < mPending.size() && mPending[used].time < end; used++ )
+	{
+		const timedinput& due = mPending[used];
+		if( due.input == INPUT_LAUNCH )
+		{
+			launched = launched || due.control == PADDLE_PRESS;
+			continue;
+		}
+
+		timedpaddleinput t;
+		t.at = due.time <= start || end <= start ? 0 : (int)( ( due.time - start ) * paddleSubsteps / ( end - start ) );
+		t.control = due.control;
+		t.input = due.input;
+		t.value = due.value;
+
+		//A nudge moves the paddle whenever in the tick it came, so a run of mouse motion takes one slot
+		if( due.control == PADDLE_NUDGE )
+		{
+			while( used + 1 < mPending.size() && mPending[used + 1].time < end && mPending[used + 1].control == PADDLE_NUDGE )
+			{
+				used++;
+				t.value += mPending[used].value;
+			}
+			t.input = t.value < 0 ? INPUT_LEFT : INPUT_RIGHT;
+		}
+		p.queueTimed( t );
+	}
+	mPending.erase( mPending.begin(), mPending.begin() + used );
+
+	return launched;
+}
+
+int LInputSampler::getDropped()
+{
+	return SDL_AtomicGet( &mDropped );
+}
+
+int SDLCALL LInputSampler::watch( void* data, SDL_Event* e )
+{
+	LInputSampler* sampler = (LInputSampler*)data;
+	timedinput in;
+	in.time = SDL_GetPerformanceCounter();
+	in.value = 0;
+
+	if( ( e->type == SDL_KEYDOWN || e->type == SDL_KEYUP ) && e->key.repeat == 0 )
+	{
+		switch( e->key.keysym.sym )
+		{
+			case SDLK_LEFT: in.input = INPUT_LEFT; break;
+			case SDLK_RIGHT: in.input = INPUT_RIGHT; break;
+			case SDLK_SPACE: in.input = INPUT_LAUNCH; break;
+			default: return 1;
+		}
+		in.control = e->type == SDL_KEYDOWN ? PADDLE_PRESS : PADDLE_RELEASE;
+		sampler->push( sampler->mEventInputs, in );
+	}
+	else if( e->type == SDL_MOUSEMOTION && e->motion.xrel != 0 )
+	{
+		//Relative motion moves the paddle pixel for pixel
+		in.control = PADDLE_NUDGE;
+		in.input = e->motion.xrel < 0 ? INPUT_LEFT : INPUT_RIGHT;
+		in.value = (float)e->motion.xrel;
+		sampler->push( sampler->mEventInputs, in );
+	}
+
+	return 1;
+}
+
+int LInputSampler::run( void* data )
+{
+	LInputSampler* sampler = (LInputSampler*)data;
+	Uint32 interval = 1000 / sampler->mRate;
+
+	while( !SDL_AtomicGet( &sampler->mQuit ) )
+	{
+		SDL_LockJoysticks();
+		SDL_GameControllerUpdate();
+		if( SDL_NumJoysticks() != sampler->mAttached )
+		{
+			sampler->openPads();
+		}
+		sampler->samplePads( SDL_GetPerformanceCounter() );
+		SDL_UnlockJoysticks();
+
+		SDL_Delay( interval > 0 ? interval : 1 );
+	}
+
+	SDL_LockJoysticks();
+	for( int i = 0; i < sampler->mNumPads; i++ )
+	{
+		SDL_GameControllerClose( sampler->mPads[i] );
+	}
+	sampler->mNumPads = 0;
+	sampler->mAttached = -1;
+	SDL_UnlockJoysticks();
+
+	return 0;
+}
+
+void LInputSampler::openPads()
+{
+	for( int i = 0; i < mNumPads; i++ )
+	{
+		SDL_GameControllerClose( mPads[i] );
+	}
+	mNumPads = 0;
+
+	mAttached = SDL_NumJoysticks();
+	for( int j = 0; j < mAttached && mNumPads < maxInputPads; j++ )
+	{
+		if( SDL_IsGameController( j ) )
+		{
+			SDL_GameController* pad = SDL_GameControllerOpen( j );
+			if( pad != NULL )
+			{
+				mPads[mNumPads++] = pad;
+			}
+		}
+	}
+}
+
+void LInputSampler::samplePads( Uint64 now )
+{
+	//Any pad's buttons count, the stick is the first one pushed past the dead zone
+	float axis = 0;
+	bool left = false, right = false, launch = false;
+	for( int i = 0; i < mNumPads; i++ )
+	{
+		SDL_GameController* pad = mPads[i];
+		if( !SDL_GameControllerGetAttached( pad ) )
+		{
+			continue;
+		}
+
+		left = left || SDL_GameControllerGetButton( pad, SDL_CONTROLLER_BUTTON_DPAD_LEFT );
+		right = right || SDL_GameControllerGetButton( pad, SDL_CONTROLLER_BUTTON_DPAD_RIGHT );
+		launch = launch || SDL_GameControllerGetButton( pad, SDL_CONTROLLER_BUTTON_A );
+
+		int x = SDL_GameControllerGetAxis( pad, SDL_CONTROLLER_AXIS_LEFTX );
+		if( axis == 0 && ( x > stickDeadZone || x < -stickDeadZone ) )
+		{
+			axis = ( x > 0 ? x - stickDeadZone : x + stickDeadZone ) / (float)( 32767 - stickDeadZone );
+			axis = axis > 1 ? 1 : axis < -1 ? -1 : axis;
+		}
+	}
+
+	timedinput in;
+	in.time = now;
+	in.value = 0;
+
+	if( left != mLastLeft )
+	{
+		in.control = left ? PADDLE_PRESS : PADDLE_RELEASE;
+		in.input = INPUT_LEFT;
+		push( mPadInputs, in );
+		mLastLeft = left;
+	}
+	if( right != mLastRight )
+	{
+		in.control = right ? PADDLE_PRESS : PADDLE_RELEASE;
+		in.input = INPUT_RIGHT;
+		push( mPadInputs, in );
+		mLastRight = right;
+	}
+	if( launch != mLastLaunch )
+	{
+		in.control = launch ? PADDLE_PRESS : PADDLE_RELEASE;
+		in.input = INPUT_LAUNCH;
+		push( mPadInputs, in );
+		mLastLaunch = launch;
+	}
+
+	//Small wobbles of the stick aren't worth a queue slot, but coming back to the centre is
+	float change = axis - mLastAxis;
+	if( change > stickStep || change < -stickStep || ( axis == 0 && mLastAxis != 0 ) )
+	{
+		in.control = PADDLE_AXIS;
+		in.input = axis < 0 ? INPUT_LEFT : INPUT_RIGHT;
+		in.value = axis;
+		push( mPadInputs, in );
+		mLastAxis = axis;
+	}
+}
+
+void LInputSampler::push( spscring<timedinput, 1024>& ring, const timedinput& in )
+{
+	//A full ring means nobody is taking input, nothing is lost that the game would use
+	if( !ring.push( in ) )
+	{
+		SDL_AtomicAdd( &mDropped, 1 );
+	}
+}
@@ -0,0 +1,97 @@
+/*Timestamped paddle input. Every press, release, stick move and mouse motion
+is stamped with the performance counter when it is read and queued on a
+lock-free ring. Each tick then hands the paddle the inputs that fall inside
+it, at their time within the tick, so a tap shorter than a frame still moves
+the paddle for as long as the key was held.
+
+Gamepads are read on a sampling thread of its own, at a fixed rate well above
+the frame rate. Keyboard and mouse can only be read by the thread that pumps
+SDL's events, so an event watch stamps them as the main thread pumps. The two
+kinds go on separate rings, keeping one producer per ring, and are merged by
+time when they are taken.
+
+Keyboard and mouse stamps are only as fine as the pumping. The game turns the
+late latch on with the sampler, so events are pumped every millisecond while
+it waits out the frame, but one that comes in while the frame is simulated,
+drawn or presented is stamped when the next frame handles its events.*/
+
+#pragma once
+
+#include <SDL.h>
+#include <vector>
+#include "BrickSim.h"
+#include "BrickRing.h"
+
+//Most gamepads read at once
+const int maxInputPads = 4;
+
+//An input and the performance counter when it was read
+struct timedinput
+{
+	Uint64 time;
+	paddlecontrol control;
+	gameinput input;
+	float value;
+};
+
+class LInputSampler
+{
+	public:
+		//Initializes variables
+		LInputSampler();
+
+		//Stops the sampling thread
+		~LInputSampler();
+
+		//Starts reading gamepads rate times a second on the sampling thread and stamping keyboard
+		//and mouse events. The mouse is captured for relative motion. The video and game controller
+		//subsystems must be initialized.
+		bool start( int rate );
+
+		//Stops sampling and releases the mouse and gamepads
+		void stop();
+
+		//Queues on p every input stamped before end, at its time within the tick from start to end.
+		//Older inputs go at the start of the tick, newer ones wait for a later tick. Returns true if
+		//launch was pressed.
+		bool feedTick( Uint64 start, Uint64 end, paddle& p );
+
+		//Inputs dropped because a ring was full
+		int getDropped();
+
+	private:
+		//Stamps keyboard and mouse events as SDL queues them, runs on the thread pumping events
+		static int SDLCALL watch( void* sampler, SDL_Event* e );
+
+		//Sampling thread entry point
+		static int run( void* sampler );
+
+		//Opens every attached gamepad, closing any open ones first. Sampling thread only.
+		void openPads();
+
+		//Reads the pads and queues whatever changed since the last read. Sampling thread only.
+		void samplePads( Uint64 now );
+
+		//Pushes onto ring, counting it as dropped if full
+		void push( spscring<timedinput, 1024>& ring, const timedinput& in );
+
+		//Keyboard and mouse from the event watch, gamepads from the sampling thread
+		spscring<timedinput, 1024> mEventInputs;
+		spscring<timedinput, 1024> mPadInputs;
+
+		//Taken off the rings but not yet due, oldest first
+		std::vector<timedinput> mPending;
+
+		SDL_Thread* mThread;
+		SDL_atomic_t mQuit;
+		SDL_atomic_t mDropped;
+		int mRate;
+		bool mWatching;
+
+		//Open gamepads and what they read last time, owned by the sampling thread
+		SDL_GameController* mPads[maxInputPads];
+		int mNumPads;
+		int mAttached;
+		float mLastAxis;
+		bool mLastLeft, mLastRight, mLastLaunch;
+};
@@ -0,0 +1,401 @@
+/*Brick levels as data.*/
+
+#include "BrickLevel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Which of the six arrays holds what
+enum levelarray
+{
+	LEVEL_X, LEVEL_Y, LEVEL_W, LEVEL_H, LEVEL_TYPE, LEVEL_HP
+};
+
+bricklevel::bricklevel()
+{
+	mCount = 0;
+	for( int a = 0; a < 6; a++ )
+	{
+		mArrays[a] = NULL;
+	}
+	mGridOriginX = 0;
+	mGridOriginY = 0;
+	mGridCols = 0;
+	mGridRows = 0;
+	mGridStarts = NULL;
+	mGridSlots = NULL;
+}
+
+bool bricklevel::load( const char* path )
+{
+	FILE* file = fopen( path, "rb" );
+	if( file == NULL )
+	{
+		printf( "Unable to open level %s!\n", path );
+		return false;
+	}
+
+	unsigned int magic = 0;
+	size_t got = fread( &magic, 1, sizeof( magic ), file );
+	fclose( file );
+
+	return got == sizeof( magic ) && magic == levelMagic ? loadBinary( path ) : loadText( path );
+}
+
+bool bricklevel::loadText( const char* path )
+{
+	FILE* file = fopen( path, "r" );
+	if( file == NULL )
+	{
+		printf( "Unable to open level %s!\n", path );
+		return false;
+	}
+
+	mFile.close();
+	for( int a = 0; a < 6; a++ )
+	{
+		mOwned[a].clear();
+	}
+	mGridCols = 0;
+	mGridRows = 0;
+	name.clear();
+
+	int originX = 0, originY = 0;
+	int cellW = brick::brick_width, cellH = brick::brick_height;
+	int hp = 1;
+	bool inGrid = false;
+	int gridRow = 0;
+	bool success = true;
+
+	char line[4096];
+	for( int lineNumber = 1; success && fgets( line, sizeof( line ), file ) != NULL; lineNumber++ )
+	{
+		line[strcspn( line, "\r\n" )] = '\0';
+
+		if( inGrid )
+		{
+			if( strcmp( line, "end" ) == 0 )
+			{
+				inGrid = false;
+				continue;
+			}
+
+			for( int col = 0; line[col] != '\0'; col++ )
+			{
+				char c = line[col];
+				if( c == '.' || c == ' ' )
+				{
+					continue;
+				}
+				if( c != '?' && ( c < '0' || c >= '0' + numBrickTypes ) )
+				{
+					printf( "%s:%d: '%c' is not a brick type!\n", path, lineNumber, c );
+					success = false;
+					break;
+				}
+
+				mOwned[LEVEL_X].push_back( originX + col * cellW );
+				mOwned[LEVEL_Y].push_back( originY + gridRow * cellH );
+				mOwned[LEVEL_TYPE].push_back( c == '?' ? randomBrickType : c - '0' );
+				mOwned[LEVEL_HP].push_back( hp );
+			}
+			gridRow++;
+			continue;
+		}
+
+		char word[32];
+		if( sscanf( line, "%31s", word ) != 1 || word[0] == '#' )
+		{
+			continue;
+		}
+
+		char type[8];
+		int x, y, brickHp = 1;
+		if( strcmp( word, "name" ) == 0 )
+		{
+			const char* rest = line + strspn( line, " \t" ) + 4;
+			name = rest + strspn( rest, " \t" );
+		}
+		else if( strcmp( word, "origin" ) == 0 )
+		{
+			success = sscanf( line, "%*s %d %d", &originX, &originY ) == 2;
+		}
+		else if( strcmp( word, "cell" ) == 0 )
+		{
+			success = sscanf( line, "%*s %d %d", &cellW, &cellH ) == 2 && cellW > 0 && cellH > 0;
+		}
+		else if( strcmp( word, "hp" ) == 0 )
+		{
+			success = sscanf( line, "%*s %d", &hp ) == 1 && hp > 0;
+		}
+		else if( strcmp( word, "grid" ) == 0 )
+		{
+			inGrid = true;
+			gridRow = 0;
+		}
+		else if( strcmp( word, "brick" ) == 0 && sscanf( line, "%*s %d %d %7s %d", &x, &y, type, &brickHp ) >= 3 )
+		{
+			int t = type[0] == '?' ? randomBrickType : atoi( type );
+			success = ( t >= 0 || t == randomBrickType ) && t < numBrickTypes && brickHp > 0;
+
+			mOwned[LEVEL_X].push_back( x );
+			mOwned[LEVEL_Y].push_back( y );
+			mOwned[LEVEL_TYPE].push_back( t );
+			mOwned[LEVEL_HP].push_back( brickHp );
+		}
+		else
+		{
+			success = false;
+		}
+
+		if( !success )
+		{
+			printf( "%s:%d: can't read \"%s\"!\n", path, lineNumber, line );
+		}
+	}
+	fclose( file );
+
+	if( success && inGrid )
+	{
+		printf( "%s: grid without an end!\n", path );
+		success = false;
+	}
+
+	//Every brick is brick sized, the game draws them from fixed size sprites
+	int width = brick::brick_width, height = brick::brick_height;
+	mOwned[LEVEL_W].assign( mOwned[LEVEL_X].size(), width );
+	mOwned[LEVEL_H].assign( mOwned[LEVEL_X].size(), height );
+	useOwned();
+
+	return success;
+}
+
+bool bricklevel::loadBinary( const char* path )
+{
+	for( int a = 0; a < 6; a++ )
+	{
+		mOwned[a].clear();
+	}
+	useOwned();
+
+	if( !mFile.open( path ) )
+	{
+		printf( "Unable to open level %s!\n", path );
+		return false;
+	}
+
+	const unsigned char* data = mFile.getData();
+	size_t size = mFile.getSize();
+	const levelheader* header = (const levelheader*)data;
+	if( size < sizeof( levelheader ) || header->magic != levelMagic || header->byteOrder != 0x01020304 )
+	{
+		printf( "%s is not a level compiled on this platform!\n", path );
+		mFile.close();
+		return false;
+	}
+	if( header->version != levelVersion )
+	{
+		printf( "Level %s is version %u, this build reads version %u!\n", path, header->version, levelVersion );
+		mFile.close();
+		return false;
+	}
+
+	//Every array has to lie inside the file and be aligned for the int loads
+	size_t count = header->numBricks;
+	bool success = count <= 0x7FFFFFFF;
+	for( int a = 0; a < 6 && success; a++ )
+	{
+		success = header->arrays[a] % sizeof( int ) == 0 && header->arrays[a] <= size && count * sizeof( int ) <= size - header->arrays[a];
+	}
+
+	size_t cells = (size_t)header->gridCols * header->gridRows;
+	const unsigned int* starts = NULL;
+	const unsigned int* slots = NULL;
+	if( success && cells > 0 )
+	{
+		success = header->gridStarts % sizeof( int ) == 0 && header->gridStarts <= size && ( cells + 1 ) * sizeof( int ) <= size - header->gridStarts;
+		if( success )
+		{
+			starts = (const unsigned int*)( data + header->gridStarts );
+			success = starts[0] == 0 && header->gridSlots % sizeof( int ) == 0 && header->gridSlots <= size && starts[cells] <= ( size - header->gridSlots ) / sizeof( int );
+		}
+		for( size_t c = 0; c < cells && success; c++ )
+		{
+			success = starts[c] <= starts[c + 1];
+		}
+		if( success )
+		{
+			slots = (const unsigned int*)( data + header->gridSlots );
+			for( unsigned int s = 0; s < starts[cells] && success; s++ )
+			{
+				success = slots[s] < count;
+			}
+		}
+	}
+
+	//The same brick types and hit points the text format accepts
+	if( success )
+	{
+		const int* types = (const int*)( data + header->arrays[LEVEL_TYPE] );
+		const int* hps = (const int*)( data + header->arrays[LEVEL_HP] );
+		for( size_t i = 0; i < count && success; i++ )
+		{
+			success = ( types[i] >= 0 || types[i] == randomBrickType ) && types[i] < numBrickTypes && hps[i] > 0;
+		}
+	}
+
+	if( !success )
+	{
+		printf( "Level %s is damaged!\n", path );
+		mFile.close();
+		return false;
+	}
+
+	mCount = (int)count;
+	for( int a = 0; a < 6; a++ )
+	{
+		mArrays[a] = (const int*)( data + header->arrays[a] );
+	}
+
+	mGridOriginX = header->gridOriginX;
+	mGridOriginY = header->gridOriginY;
+	mGridCols = cells > 0 ? header->gridCols : 0;
+	mGridRows = cells > 0 ? header->gridRows : 0;
+	mGridStarts = starts;
+	mGridSlots = slots;
+
+	name.assign( header->name, strnlen( header->name, sizeof( header->name ) ) );
+	return true;
+}
+
+bool bricklevel::saveBinary( const char* path, bool withGrid ) const
+{
+	levelheader header;
+	memset( &header, 0, sizeof( header ) );
+	header.magic = levelMagic;
+	header.version = levelVersion;
+	header.byteOrder = 0x01020304;
+	header.numBricks = mCount;
+	strncpy( header.name, name.c_str(), sizeof( header.name ) - 1 );
+
+	//The grid is built exactly as the game would, then saved as it stands
+	int originX = 0, originY = 0, cols = 0, rows = 0;
+	std::vector<unsigned int> starts, slots;
+	if( withGrid && mCount > 0 )
+	{
+		brickfield field;
+		brickgrid grid;
+		apply( field, grid, 1 );
+		grid.save( originX, originY, cols, rows, starts, slots );
+	}
+
+	//Lay the arrays out one after another on aligned offsets
+	size_t offset = sizeof( levelheader );
+	struct align
+	{
+		static size_t up( size_t offset )
+		{
+			return ( offset + levelAlignment - 1 ) / levelAlignment * levelAlignment;
+		}
+	};
+
+	for( int a = 0; a < 6; a++ )
+	{
+		offset = align::up( offset );
+		header.arrays[a] = (unsigned int)offset;
+		offset += mCount * sizeof( int );
+	}
+	if( cols > 0 )
+	{
+		header.gridOriginX = originX;
+		header.gridOriginY = originY;
+		header.gridCols = cols;
+		header.gridRows = rows;
+
+		offset = align::up( offset );
+		header.gridStarts = (unsigned int)offset;
+		offset += starts.size() * sizeof( int );
+
+		offset = align::up( offset );
+		header.gridSlots = (unsigned int)offset;
+		offset += slots.size() * sizeof( int );
+	}
+
+	std::vector<unsigned char> out( offset, 0 );
+	memcpy( &out[0], &header, sizeof( header ) );
+	for( int a = 0; a < 6 && mCount > 0; a++ )
+	{
+		memcpy( &out[header.arrays[a]], mArrays[a], mCount * sizeof( int ) );
+	}
+	if( cols > 0 )
+	{
+		memcpy( &out[header.gridStarts], starts.data(), starts.size() * sizeof( int ) );
+		if( !slots.empty() )
+		{
+			memcpy( &out[header.gridSlots], slots.data(), slots.size() * sizeof( int ) );
+		}
+	}
+
+	FILE* file = fopen( path, "wb" );
+	if( file == NULL )
+	{
+		printf( "Unable to create level %s!\n", path );
+		return false;
+	}
+
+	bool success = fwrite( out.data(), 1, out.size(), file ) == out.size();
+	if( fclose( file ) != 0 || !success )
+	{
+		printf( "Unable to write level %s!\n", path );
+		return false;
+	}
+	return true;
+}
+
+void bricklevel::apply( brickfield &field, brickgrid &grid, unsigned int seed ) const
+{
+	field.assign( mCount, mArrays[LEVEL_X], mArrays[LEVEL_Y], mArrays[LEVEL_W], mArrays[LEVEL_H], mArrays[LEVEL_TYPE], mArrays[LEVEL_HP] );
+
+	//Same sequence brickgame::reset draws its types from
+	unsigned int random = seed;
+	for( int i = 0; i < mCount; i++ )
+	{
+		if( field.types[i] == randomBrickType )
+		{
+			random = random * 1664525u + 1013904223u;
+			field.types[i] = ( random >> 8 ) % numBrickTypes;
+		}
+	}
+
+	if( mGridCols > 0 )
+	{
+		grid.assign( mGridOriginX, mGridOriginY, mGridCols, mGridRows, mGridStarts, mGridSlots );
+	}
+	else
+	{
+		grid.build( field );
+	}
+}
+
+int bricklevel::size() const
+{
+	return mCount;
+}
+
+bool bricklevel::hasGrid() const
+{
+	return mGridCols > 0;
+}
+
+void bricklevel::useOwned()
+{
+	mCount = mOwned[LEVEL_X].size();
+	for( int a = 0; a < 6; a++ )
+	{
+		mArrays[a] = mOwned[a].data();
+	}
+	mGridCols = 0;
+	mGridRows = 0;
+	mGridStarts = NULL;
+	mGridSlots = NULL;
+}
@@ -0,0 +1,113 @@
+/*Brick levels as data. Plain C++, no SDL.
+
+The text form is for editing by hand, one directive per line:
+
+	# comment
+	name Classic
+	origin 40 20        top left of the grid rows that follow, default 0 0
+	cell 80 20          spacing of grid columns and rows, default the brick size
+	hp 2                hit points of the grid bricks that follow, default 1
+	grid                each line up to "end" is a row of bricks: . or space
+	0123?.012           for none, 0 to 5 for a brick type, ? for a random type
+	end
+	brick 360 300 4 3   one brick at x y with a type (or ?) and hit points
+
+LevelCompiler turns it into the binary form, which is laid out the way the
+game stores bricks. Loading maps the file and copies each array into the
+brickfield in one go, no parsing. The grid the game looks bricks up through
+can be saved in the file too, so it need not be built at load either.
+
+Binary layout, integers in the byte order of the machine that compiled it:
+	levelheader
+	x, y, w, h, type and hit point arrays, numBricks ints each
+	grid cell starts, gridCols * gridRows + 1 unsigned ints, if there is a grid
+	grid slots, as many as the last cell start
+each array starting on a levelAlignment boundary.
+
+Random types are stored as -1 and drawn from the game's seed when the level
+is laid out, so a compiled level plays with the same seeds as the text one.*/
+
+#pragma once
+
+#include "BrickSim.h"
+#include "BrickMapped.h"
+#include <string>
+#include <vector>
+
+//"BLVL"
+const unsigned int levelMagic = 0x4C564C42;
+
+//Bump whenever levelheader or the array layout changes
+const unsigned int levelVersion = 1;
+
+//Array alignment in the binary form
+const unsigned int levelAlignment = 64;
+
+//Type of a brick whose type is drawn from the seed
+const int randomBrickType = -1;
+
+struct levelheader
+{
+	unsigned int magic;
+	unsigned int version;
+
+	//Written as 0x01020304, a level from a machine of the other byte order reads differently
+	unsigned int byteOrder;
+	unsigned int numBricks;
+
+	char name[32];
+
+	//File offsets of the x, y, w, h, type and hit point arrays
+	unsigned int arrays[6];
+
+	//Precomputed grid, gridCols and gridRows are 0 without one
+	int gridOriginX, gridOriginY;
+	unsigned int gridCols, gridRows;
+	unsigned int gridStarts;
+	unsigned int gridSlots;
+};
+
+class bricklevel
+{
+public:
+	bricklevel();
+
+	//Reads either form, telling them apart by the binary magic.
+	//Prints the reason, and the line for the text form, on failure.
+	bool load( const char* path );
+
+	//Parses the text form
+	bool loadText( const char* path );
+
+	//Maps the binary form, its arrays are used in place from the mapping
+	bool loadBinary( const char* path );
+
+	//Writes the binary form, with the grid precomputed if withGrid
+	bool saveBinary( const char* path, bool withGrid ) const;
+
+	//Replaces field and grid with the level, random types drawn from seed
+	void apply( brickfield &field, brickgrid &grid, unsigned int seed ) const;
+
+	int size() const;
+	bool hasGrid() const;
+
+	std::string name;
+
+private:
+	//Points the arrays at the owned text level data
+	void useOwned();
+
+	int mCount;
+	const int* mArrays[6];
+
+	int mGridOriginX, mGridOriginY;
+	int mGridCols, mGridRows;
+	const unsigned int* mGridStarts;
+	const unsigned int* mGridSlots;
+
+	//Bricks of a text level, one vector per array
+	std::vector<int> mOwned[6];
+
+	//Backing of a binary level
+	mappedfile mFile;
+};
@@ -0,0 +1,126 @@
+/*Read only file mapping.*/
+
+#include "BrickMapped.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+mappedfile::mappedfile()
+{
+	//Initialize
+	mData = NULL;
+	mSize = 0;
+
+	#ifdef _WIN32
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = NULL;
+	#endif
+}
+
+mappedfile::~mappedfile()
+{
+	//Unmap
+	close();
+}
+
+bool mappedfile::open( const char* path )
+{
+	//Get rid of preexisting mapping
+	close();
+
+	#ifdef _WIN32
+	mFile = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if( mFile == INVALID_HANDLE_VALUE )
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	GetFileSizeEx( mFile, &size );
+	mMapping = CreateFileMappingA( mFile, NULL, PAGE_READONLY, 0, 0, NULL );
+	if( mMapping != NULL )
+	{
+		mData = (const unsigned char*)MapViewOfFile( mMapping, FILE_MAP_READ, 0, 0, 0 );
+	}
+	if( mData == NULL )
+	{
+		printf( "Unable to map %s!\n", path );
+		close();
+		return false;
+	}
+	mSize = (size_t)size.QuadPart;
+	#else
+	int fd = ::open( path, O_RDONLY );
+	if( fd < 0 )
+	{
+		return false;
+	}
+
+	struct stat st;
+	if( fstat( fd, &st ) == 0 && st.st_size > 0 )
+	{
+		void* data = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( data != MAP_FAILED )
+		{
+			mData = (const unsigned char*)data;
+			mSize = st.st_size;
+		}
+	}
+
+	//The mapping stays valid without the descriptor
+	::close( fd );
+
+	if( mData == NULL )
+	{
+		printf( "Unable to map %s!\n", path );
+		return false;
+	}
+	#endif
+
+	return true;
+}
+
+void mappedfile::close()
+{
+	#ifdef _WIN32
+	if( mData != NULL )
+	{
+		UnmapViewOfFile( mData );
+	}
+	if( mMapping != NULL )
+	{
+		CloseHandle( mMapping );
+		mMapping = NULL;
+	}
+	if( mFile != INVALID_HANDLE_VALUE )
+	{
+		CloseHandle( mFile );
+		mFile = INVALID_HANDLE_VALUE;
+	}
+	#else
+	if( mData != NULL )
+	{
+		munmap( (void*)mData, mSize );
+	}
+	#endif
+
+	mData = NULL;
+	mSize = 0;
+}
+
+const unsigned char* mappedfile::getData() const
+{
+	return mData;
+}
+
+size_t mappedfile::getSize() const
+{
+	return mSize;
+}
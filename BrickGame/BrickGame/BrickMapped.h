@@ -0,0 +1,39 @@
+/*Read only file mapping, mmap on POSIX and MapViewOfFile on Windows. Plain C++,
+no SDL, shared by the asset pack and compiled levels.*/
+
+#pragma once
+
+#include <stddef.h>
+
+//A read only file mapped into memory
+class mappedfile
+{
+	public:
+		//Initializes variables
+		mappedfile();
+
+		//Unmaps the file
+		~mappedfile();
+
+		//Maps the whole of the file at path
+		bool open( const char* path );
+
+		//Unmaps the file
+		void close();
+
+		const unsigned char* getData() const;
+		size_t getSize() const;
+
+	private:
+		//Mappings are not shared
+		mappedfile( const mappedfile& );
+		mappedfile& operator=( const mappedfile& );
+
+		const unsigned char* mData;
+		size_t mSize;
+
+		#ifdef _WIN32
+		void* mFile;
+		void* mMapping;
+		#endif
+};
@@ -0,0 +1,178 @@
+/*Multi-ball stress mode.*/
+
+#include "BrickMultiBall.h"
+
+//Brick rows laid out from the top of the screen, below them is open space for the balls
+const int multiballRows = 14;
+
+multiballgame::multiballgame( int numBalls, unsigned int seed )
+{
+	tickRate = referenceTickRate;
+	gamescore = 0;
+	fieldsCleared = 0;
+	bricksDestroyed = 0;
+	paddleHits = 0;
+	mSeed = seed;
+
+	layout();
+
+	paddleEntity = world.create(paddleComponents);
+	boxcollider paddleShape = { paddle::paddle_width, paddle::paddle_height };
+	*world.get<boxcollider>(paddleEntity) = paddleShape;
+	placePaddle();
+
+	//Scattered between the bricks and the paddle, all heading upwards at different angles
+	int top = brick::brick_height * (multiballRows + 2);
+	int bottom = SCREEN_HEIGHT - SCOREBOARD_HEIGHT - paddle::paddle_height - ball::ball_HEIGHT;
+	for(int i = 0; i < numBalls; i++)
+	{
+		int x = ball::ball_WIDTH/2 + nextRandom() % (SCREEN_WIDTH - ball::ball_WIDTH);
+		int y = top + nextRandom() % (bottom - top);
+		int velX = 2 + nextRandom() % (ball::ball_VEL - 1);
+		int velY = 2 + nextRandom() % (ball::ball_VEL - 1);
+
+		transform at = { x, y };
+		velocity heading = { nextRandom() % 2 ? velX : -velX, -velY, 0, 0 };
+		circlecollider shape = { ball::ball_WIDTH/2 };
+		sprite look = { SHEET_BALL, 0, -ball::ball_WIDTH/2, -ball::ball_HEIGHT/2 };
+
+		entity e = world.create(multiballComponents);
+		*world.get<transform>(e) = at;
+		*world.get<velocity>(e) = heading;
+		*world.get<circlecollider>(e) = shape;
+		*world.get<sprite>(e) = look;
+	}
+}
+
+int multiballgame::numBalls() const
+{
+	//Every entity but the paddle
+	return world.size() - 1;
+}
+
+void multiballgame::layout()
+{
+	gameBricks.clear();
+
+	int perRow = SCREEN_WIDTH / brick::brick_width;
+	for(int i = 0; i < perRow * multiballRows; i++)
+	{
+		brick b;
+		b.bricktype = i % numBrickTypes;
+		b.arrange((i % perRow) * brick::brick_width, brick::brick_height * (i / perRow + 1));
+		gameBricks.add(b);
+	}
+
+	grid.build(gameBricks);
+}
+
+void multiballgame::step( taskpool &pool )
+{
+	moveBalls(pool);
+	removeHit();
+}
+
+void multiballgame::moveBalls( taskpool &pool )
+{
+	mainPaddle.move(tickRate);
+	placePaddle();
+
+	//Every ball moves against the field as it was at the start of the tick
+	circleSystem(world, gameBricks, grid, paddleEntity, tickRate, &pool);
+}
+
+void multiballgame::placePaddle()
+{
+	transform* at = world.get<transform>(paddleEntity);
+	at->x = mainPaddle.mPaddleCollider.x;
+	at->y = mainPaddle.mPaddleCollider.y;
+	world.get<velocity>(paddleEntity)->x = mainPaddle.mVelX;
+}
+
+void multiballgame::removeHit()
+{
+	bricksDestroyed = 0;
+	paddleHits = 0;
+	destroyed.clear();
+
+	//Then their hits are applied in ball order. A brick already removed by a lower numbered ball
+	//this tick has a stale handle by now and is skipped.
+	world.each(multiballComponents, [this]( archetype &balls )
+	{
+		for(int b = 0; b < balls.size(); b++)
+		{
+			applyHits(balls.contactLists[b]);
+		}
+	});
+
+	if(gameBricks.empty())
+	{
+		layout();
+		fieldsCleared++;
+	}
+}
+
+void multiballgame::applyHits( const contacts &hits )
+{
+	paddleHits += hits.paddle;
+
+	for(int h = 0; h < hits.count; h++)
+	{
+		brickhandle handle = hits.bricks[h];
+		int i = gameBricks.indexOf(handle);
+		if(i < 0)
+		{
+			continue;
+		}
+
+		gameBricks.hit[i] = true;
+		gameBricks.sides[i] = hits.sides[h];
+
+		//A brick with hit points to spare only loses one
+		if(gameBricks.hitPoints[i] > 1)
+		{
+			gameBricks.hitPoints[i]--;
+			continue;
+		}
+
+		brickdestroyed gone = { handle, gameBricks.get(i) };
+		destroyed.push_back(gone);
+
+		grid.remove(handle.slot, gameBricks.rect(i));
+		gameBricks.removeAt(i);
+
+		gamescore++;
+		bricksDestroyed++;
+	}
+}
+
+unsigned long long multiballgame::stateHash() const
+{
+	//FNV-1a over the values that make up the state
+	unsigned long long hash = hashBasis;
+
+	world.each(multiballComponents, [&hash]( const archetype &arch )
+	{
+		for(int i = 0; i < arch.size(); i++)
+		{
+			hash = hashValue(hash, arch.transforms[i].x);
+			hash = hashValue(hash, arch.transforms[i].y);
+		}
+	});
+	for(int i = 0; i < gameBricks.size(); i++)
+	{
+		hash = hashValue(hash, gameBricks.xs()[i]);
+		hash = hashValue(hash, gameBricks.ys()[i]);
+	}
+	hash = hashValue(hash, gamescore);
+	hash = hashValue(hash, fieldsCleared);
+
+	return hash;
+}
+
+unsigned int multiballgame::nextRandom()
+{
+	//Numerical Recipes LCG, top bits only
+	mSeed = mSeed * 1664525u + 1013904223u;
+	return mSeed >> 8;
+}
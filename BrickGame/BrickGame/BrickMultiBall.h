@@ -0,0 +1,81 @@
+/*Multi-ball stress mode: thousands of balls on one brick field, moved in
+parallel on a taskpool. Plain C++, no SDL.
+
+Each tick runs in two phases. First every ball moves against the field as it
+stood at the start of the tick. Balls only read the field then, so they can
+move on any thread in any order. Then, on one thread and in ball order, the
+bricks they hit are removed. Two balls hitting the same brick in one tick both
+bounce off it. The brick is destroyed once and scored to the lower numbered
+ball, so the outcome is the same however many threads moved the balls. Balls
+pass through each other.
+
+Balls are entities in an entityworld, all in one archetype of transform,
+velocity, circle, contacts and sprite. circleSystem moves them, so the balls
+are walked as flat arrays rather than as ball objects. The paddle is an
+entity too, a transform, velocity and box the balls bounce off. Input still
+drives a paddle, which places the entity once it has moved each tick.*/
+
+#pragma once
+
+#include "BrickSim.h"
+#include "BrickTasks.h"
+#include "BrickECS.h"
+
+//Components every ball entity holds
+const unsigned int multiballComponents = COMPONENT_TRANSFORM | COMPONENT_VELOCITY | COMPONENT_CIRCLE | COMPONENT_CONTACTS | COMPONENT_SPRITE;
+
+//Components of the paddle entity
+const unsigned int paddleComponents = COMPONENT_TRANSFORM | COMPONENT_VELOCITY | COMPONENT_BOX;
+
+class multiballgame
+{
+public:
+	//Scatters numBalls balls below a full field of bricks, seed picks their places and directions
+	multiballgame( int numBalls, unsigned int seed = 1 );
+
+	//Advances every ball by one tick, spread across pool's threads
+	void step( taskpool &pool );
+
+	//The two phases of a tick: move every ball in parallel, then remove the bricks they hit in ball order
+	void moveBalls( taskpool &pool );
+	void removeHit();
+
+	//Fills the top of the screen with rows of bricks
+	void layout();
+
+	//Hash of the ball positions, bricks and score, equal for equal states
+	unsigned long long stateHash() const;
+
+	//Ticks per second of simulated time
+	int tickRate;
+
+	//Balls in the order they were made, which is the order their hits are applied in
+	int numBalls() const;
+
+	//Takes the player's input and moves, the balls collide with paddleEntity
+	paddle mainPaddle;
+	entity paddleEntity;
+	entityworld world;
+	brickfield gameBricks;
+	brickgrid grid;
+
+	//Bricks destroyed so far, and fields cleared and laid out again
+	long long gamescore;
+	int fieldsCleared;
+
+	//What happened during the last step
+	int bricksDestroyed;
+	int paddleHits;
+	std::vector<brickdestroyed> destroyed;
+
+private:
+	//Places the paddle entity where mainPaddle moved to
+	void placePaddle();
+
+	//Applies one ball's hits to the field
+	void applyHits( const contacts &hits );
+
+	//Deterministic random numbers, the same sequence on every platform
+	unsigned int nextRandom();
+	unsigned int mSeed;
+};
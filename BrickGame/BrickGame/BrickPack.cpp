@@ -0,0 +1,147 @@
+/*Pre-decoded asset pack, mapped into memory.*/
+
+#include "BrickPack.h"
+#include <stdio.h>
+#include <string.h>
+
+LAssetPack::LAssetPack()
+{
+	//Initialize
+	mHeader = NULL;
+	mEntries = NULL;
+}
+
+bool LAssetPack::open( const char* path )
+{
+	mHeader = NULL;
+	mEntries = NULL;
+
+	if( !mFile.open( path ) )
+	{
+		return false;
+	}
+
+	const packheader* header = (const packheader*)mFile.getData();
+	if( mFile.getSize() < sizeof( packheader ) || header->magic != packMagic || header->byteOrder != 0x01020304 )
+	{
+		printf( "%s is not an asset pack for this machine!\n", path );
+		mFile.close();
+		return false;
+	}
+
+	if( header->version != packVersion )
+	{
+		printf( "%s is pack version %u, expected %u. Run AssetPacker again.\n", path, header->version, packVersion );
+		mFile.close();
+		return false;
+	}
+
+	//Every entry must lie inside the file
+	const packentry* entries = (const packentry*)( header + 1 );
+	bool success = mFile.getSize() >= sizeof( packheader ) + header->numEntries * sizeof( packentry );
+	for( Uint32 i = 0; success && i < header->numEntries; i++ )
+	{
+		success = entries[i].offset % packAlignment == 0 && entries[i].offset <= mFile.getSize() && entries[i].size <= mFile.getSize() - entries[i].offset;
+	}
+
+	if( !success )
+	{
+		printf( "%s is truncated or corrupt!\n", path );
+		mFile.close();
+		return false;
+	}
+
+	mHeader = header;
+	mEntries = entries;
+	return true;
+}
+
+void LAssetPack::close()
+{
+	mFile.close();
+	mHeader = NULL;
+	mEntries = NULL;
+}
+
+const packentry* LAssetPack::find( const char* name )
+{
+	if( mHeader == NULL )
+	{
+		return NULL;
+	}
+
+	//A handful of entries, a linear scan of the mapped table is fine
+	for( Uint32 i = 0; i < mHeader->numEntries; i++ )
+	{
+		if( strncmp( mEntries[i].name, name, sizeof( mEntries[i].name ) ) == 0 )
+		{
+			return &mEntries[i];
+		}
+	}
+	return NULL;
+}
+
+SDL_Texture* LAssetPack::createTexture( SDL_Renderer* renderer, const char* name )
+{
+	const packentry* entry = find( name );
+	if( entry == NULL || entry->type != PACK_IMAGE )
+	{
+		printf( "No image %s in the asset pack!\n", name );
+		return NULL;
+	}
+
+	//The pixels must be a packed four byte format, the rows must hold a whole row of them
+	//and all of them must lie inside the entry
+	Uint64 rowBytes = entry->info[2];
+	Uint32 format = entry->info[3];
+	if( SDL_ISPIXELFORMAT_FOURCC( format ) || SDL_BYTESPERPIXEL( format ) != 4 || entry->info[0] == 0 || entry->info[1] == 0 || entry->info[0] > 0x7FFFFFFF / 4 || entry->info[1] > 0x7FFFFFFF || rowBytes > 0x7FFFFFFF
+		|| rowBytes < (Uint64)entry->info[0] * 4 || rowBytes * entry->info[1] > entry->size )
+	{
+		printf( "Image %s in the asset pack is damaged!\n", name );
+		return NULL;
+	}
+
+	int width = entry->info[0];
+	int height = entry->info[1];
+	int pitch = (int)rowBytes;
+
+	SDL_Texture* texture = SDL_CreateTexture( renderer, format, SDL_TEXTUREACCESS_STATIC, width, height );
+	if( texture == NULL )
+	{
+		printf( "Unable to create texture for %s! SDL Error: %s\n", name, SDL_GetError() );
+		return NULL;
+	}
+
+	//The mapped rows go to the driver as they are
+	if( SDL_UpdateTexture( texture, NULL, mFile.getData() + entry->offset, pitch ) < 0 )
+	{
+		printf( "Unable to upload %s! SDL Error: %s\n", name, SDL_GetError() );
+		SDL_DestroyTexture( texture );
+		return NULL;
+	}
+
+	SDL_SetTextureBlendMode( texture, SDL_BLENDMODE_BLEND );
+
+	return texture;
+}
+
+Mix_Chunk* LAssetPack::createChunk( const char* name )
+{
+	const packentry* entry = find( name );
+	if( entry == NULL || entry->type != PACK_SOUND )
+	{
+		printf( "No sound %s in the asset pack!\n", name );
+		return NULL;
+	}
+
+	//Mix_QuickLoad_RAW plays the bytes as they are, so they must already be in the output format
+	int frequency, channels;
+	Uint16 format;
+	if( Mix_QuerySpec( &frequency, &format, &channels ) == 0 || frequency != (int)entry->info[0] || format != entry->info[1] || channels != (int)entry->info[2] )
+	{
+		printf( "Sound %s was packed for another mixer format!\n", name );
+		return NULL;
+	}
+
+	return Mix_QuickLoad_RAW( (Uint8*)( mFile.getData() + entry->offset ), entry->size );
+}
@@ -0,0 +1,90 @@
+/*Pre-decoded asset pack. AssetPacker decodes the PNGs and WAVs once, offline,
+into pixels in the texture format renderers take natively (color key already
+turned into alpha) and PCM in the mixer's output format. The game maps the pack
+into memory and creates textures and sound chunks straight from the mapped
+bytes, with no decoding at startup.
+
+Layout, all integers in the byte order of the machine that packed it:
+	packheader
+	packentry[numEntries]
+	data, each entry starting on a packAlignment boundary*/
+
+#pragma once
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include "BrickMapped.h"
+
+//"BPAK"
+const Uint32 packMagic = 0x4B415042;
+
+//Bump whenever packheader, packentry or the data layout changes
+const Uint32 packVersion = 1;
+
+//Entry data alignment, keeps pixel rows friendly to SIMD copies
+const Uint32 packAlignment = 64;
+
+//The mixer output format the game opens, sounds are packed already converted to it
+const int mixerFrequency = 44100;
+const Uint16 mixerFormat = AUDIO_S16SYS;
+const int mixerChannels = 2;
+
+//Pixel format images are packed in, the first texture format of most renderers
+const Uint32 packPixelFormat = SDL_PIXELFORMAT_ARGB8888;
+
+enum packentrytype
+{
+	PACK_IMAGE = 1,
+	PACK_SOUND = 2
+};
+
+struct packheader
+{
+	Uint32 magic;
+	Uint32 version;
+
+	//Written as 0x01020304, a pack from a machine of the other byte order reads differently
+	Uint32 byteOrder;
+	Uint32 numEntries;
+};
+
+struct packentry
+{
+	//File name the entry was packed from, e.g. "atlas.png"
+	char name[48];
+
+	Uint32 type;
+	Uint32 offset;
+	Uint32 size;
+
+	//PACK_IMAGE: width, height, pitch and SDL pixel format
+	//PACK_SOUND: frequency, SDL audio format, channels and unused
+	Uint32 info[4];
+};
+
+class LAssetPack
+{
+	public:
+		//Initializes variables
+		LAssetPack();
+
+		//Maps the pack at path and checks its header and table of contents
+		bool open( const char* path );
+
+		//Unmaps the pack. Sound chunks made from it play the mapped bytes, free them first.
+		void close();
+
+		//The entry packed from name, NULL if there is none
+		const packentry* find( const char* name );
+
+		//A static texture uploaded straight from the mapped pixels
+		SDL_Texture* createTexture( SDL_Renderer* renderer, const char* name );
+
+		//A chunk playing the mapped PCM in place. Fails if the mixer was opened in another format.
+		Mix_Chunk* createChunk( const char* name );
+
+	private:
+		mappedfile mFile;
+		const packheader* mHeader;
+		const packentry* mEntries;
+};
@@ -0,0 +1,334 @@
+/*Particles for brick debris and sparks.*/
+
+#include "BrickParticles.h"
+#include "BrickTrace.h"
+#include <stdlib.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BRICKPARTICLES_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BRICKPARTICLES_SSE2
+#endif
+
+//Particles a destroyed brick throws out
+const int debrisPerBrick = 24;
+const int sparksPerBrick = 8;
+
+//Particles per SIMD batch, the capacity is kept a whole number of them
+const int particleBatchWidth = 8;
+
+particlepool::particlepool( int capacity )
+{
+	capacity = (capacity + particleBatchWidth - 1) / particleBatchWidth * particleBatchWidth;
+
+	//Room for the seven arrays plus slack to align the start to 32 bytes.
+	//The original pointer is kept just in front of the aligned block.
+	size_t bytes = 7 * capacity * sizeof(float) + 32 + sizeof(void*);
+	char *raw = (char*)malloc(bytes);
+	size_t aligned = ((size_t)(raw + sizeof(void*)) + 31) & ~(size_t)31;
+	float *block = (float*)aligned;
+	((void**)block)[-1] = raw;
+
+	mBlock = block;
+	mX = block;
+	mY = block + capacity;
+	mVelX = block + 2 * capacity;
+	mVelY = block + 3 * capacity;
+	mLife = block + 4 * capacity;
+	mColor = (unsigned int*)(block + 5 * capacity);
+	mSprite = (int*)(block + 6 * capacity);
+	mSize = 0;
+	mCapacity = capacity;
+
+	floorY = (float)(SCREEN_HEIGHT - SCOREBOARD_HEIGHT);
+}
+
+particlepool::~particlepool()
+{
+	free(((void**)mBlock)[-1]);
+}
+
+void particlepool::clear()
+{
+	mSize = 0;
+}
+
+bool particlepool::spawn( float x, float y, float velX, float velY, float life, unsigned int color, int sprite )
+{
+	if(mSize == mCapacity)
+	{
+		return false;
+	}
+
+	int i = mSize++;
+	mX[i] = x;
+	mY[i] = y;
+	mVelX[i] = velX;
+	mVelY[i] = velY;
+	mLife[i] = life;
+	mColor[i] = color;
+	mSprite[i] = sprite;
+	return true;
+}
+
+int particlepool::size() const
+{
+	return mSize;
+}
+
+int particlepool::capacity() const
+{
+	return mCapacity;
+}
+
+int particlepool::updateRange( int first, int kept, float seconds )
+{
+	float fall = particleGravity * seconds;
+
+	for(int i = first; i < mSize; i++)
+	{
+		float velY = mVelY[i] + fall;
+		float x = mX[i] + mVelX[i] * seconds;
+		float y = mY[i] + velY * seconds;
+		float life = mLife[i] - seconds;
+
+		if(life > 0.0f && y < floorY)
+		{
+			mX[kept] = x;
+			mY[kept] = y;
+			mVelX[kept] = mVelX[i];
+			mVelY[kept] = velY;
+			mLife[kept] = life;
+			mColor[kept] = mColor[i];
+			mSprite[kept] = mSprite[i];
+			kept++;
+		}
+	}
+
+	return kept;
+}
+
+void particlepool::updateScalar( float seconds )
+{
+	mSize = updateRange(0, 0, seconds);
+}
+
+#if defined(BRICKPARTICLES_AVX2)
+
+//For each 8 bit keep mask, the lanes to gather so the kept ones come first, and how many there are
+struct packtable
+{
+	int lanes[256][8];
+	int counts[256];
+
+	packtable()
+	{
+		for(int mask = 0; mask < 256; mask++)
+		{
+			int n = 0;
+			for(int lane = 0; lane < 8; lane++)
+			{
+				if(mask & (1 << lane))
+				{
+					lanes[mask][n++] = lane;
+				}
+			}
+			counts[mask] = n;
+
+			//The lanes past the kept ones are written over by the next batch, any will do
+			while(n < 8)
+			{
+				lanes[mask][n++] = 0;
+			}
+		}
+	}
+};
+
+void particlepool::update( float seconds )
+{
+	TRACE_ZONE( "particles" );
+
+	static const packtable pack;
+
+	const __m256 dt = _mm256_set1_ps(seconds);
+	const __m256 fall = _mm256_set1_ps(particleGravity * seconds);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 floor = _mm256_set1_ps(floorY);
+
+	//Batches are read from i and written to kept, which never passes i, so an
+	//unaligned store of a packed batch only covers particles already read
+	int i = 0, kept = 0;
+	for(; i + particleBatchWidth <= mSize; i += particleBatchWidth)
+	{
+		__m256 velX = _mm256_load_ps(mVelX + i);
+		__m256 velY = _mm256_add_ps(_mm256_load_ps(mVelY + i), fall);
+		__m256 x = _mm256_add_ps(_mm256_load_ps(mX + i), _mm256_mul_ps(velX, dt));
+		__m256 y = _mm256_add_ps(_mm256_load_ps(mY + i), _mm256_mul_ps(velY, dt));
+		__m256 life = _mm256_sub_ps(_mm256_load_ps(mLife + i), dt);
+		__m256i color = _mm256_load_si256((const __m256i*)(mColor + i));
+		__m256i sprite = _mm256_load_si256((const __m256i*)(mSprite + i));
+
+		__m256 alive = _mm256_and_ps(_mm256_cmp_ps(life, zero, _CMP_GT_OQ), _mm256_cmp_ps(y, floor, _CMP_LT_OQ));
+		int mask = _mm256_movemask_ps(alive);
+
+		//Nothing died in this batch or before it, it stays where it is
+		if(mask == 0xFF && kept == i)
+		{
+			_mm256_store_ps(mX + i, x);
+			_mm256_store_ps(mY + i, y);
+			_mm256_store_ps(mVelY + i, velY);
+			_mm256_store_ps(mLife + i, life);
+			kept += particleBatchWidth;
+			continue;
+		}
+
+		__m256i lanes = _mm256_loadu_si256((const __m256i*)pack.lanes[mask]);
+		_mm256_storeu_ps(mX + kept, _mm256_permutevar8x32_ps(x, lanes));
+		_mm256_storeu_ps(mY + kept, _mm256_permutevar8x32_ps(y, lanes));
+		_mm256_storeu_ps(mVelX + kept, _mm256_permutevar8x32_ps(velX, lanes));
+		_mm256_storeu_ps(mVelY + kept, _mm256_permutevar8x32_ps(velY, lanes));
+		_mm256_storeu_ps(mLife + kept, _mm256_permutevar8x32_ps(life, lanes));
+		_mm256_storeu_si256((__m256i*)(mColor + kept), _mm256_permutevar8x32_epi32(color, lanes));
+		_mm256_storeu_si256((__m256i*)(mSprite + kept), _mm256_permutevar8x32_epi32(sprite, lanes));
+		kept += pack.counts[mask];
+	}
+
+	mSize = updateRange(i, kept, seconds);
+}
+
+const char *particleUpdatePath()
+{
+	return "AVX2";
+}
+
+#elif defined(BRICKPARTICLES_SSE2)
+
+void particlepool::update( float seconds )
+{
+	TRACE_ZONE( "particles" );
+
+	const __m128 dt = _mm_set1_ps(seconds);
+	const __m128 fall = _mm_set1_ps(particleGravity * seconds);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 floor = _mm_set1_ps(floorY);
+
+	//SSE2 has no lane shuffle by mask, so only the moving is done four at a time
+	//and a batch with deaths in it is packed lane by lane
+	int i = 0, kept = 0;
+	for(; i + 4 <= mSize; i += 4)
+	{
+		__m128 velY = _mm_add_ps(_mm_load_ps(mVelY + i), fall);
+		__m128 x = _mm_add_ps(_mm_load_ps(mX + i), _mm_mul_ps(_mm_load_ps(mVelX + i), dt));
+		__m128 y = _mm_add_ps(_mm_load_ps(mY + i), _mm_mul_ps(velY, dt));
+		__m128 life = _mm_sub_ps(_mm_load_ps(mLife + i), dt);
+
+		__m128 alive = _mm_and_ps(_mm_cmpgt_ps(life, zero), _mm_cmplt_ps(y, floor));
+		int mask = _mm_movemask_ps(alive);
+
+		//Nothing died in this batch or before it, it stays where it is
+		if(mask == 0xF && kept == i)
+		{
+			_mm_store_ps(mX + i, x);
+			_mm_store_ps(mY + i, y);
+			_mm_store_ps(mVelY + i, velY);
+			_mm_store_ps(mLife + i, life);
+			kept += 4;
+			continue;
+		}
+
+		//Nothing died in this batch, it moves down whole
+		if(mask == 0xF)
+		{
+			_mm_storeu_ps(mX + kept, x);
+			_mm_storeu_ps(mY + kept, y);
+			_mm_storeu_ps(mVelX + kept, _mm_load_ps(mVelX + i));
+			_mm_storeu_ps(mVelY + kept, velY);
+			_mm_storeu_ps(mLife + kept, life);
+			_mm_storeu_si128((__m128i*)(mColor + kept), _mm_load_si128((const __m128i*)(mColor + i)));
+			_mm_storeu_si128((__m128i*)(mSprite + kept), _mm_load_si128((const __m128i*)(mSprite + i)));
+			kept += 4;
+			continue;
+		}
+
+		float xs[4], ys[4], velYs[4], lifes[4];
+		_mm_storeu_ps(xs, x);
+		_mm_storeu_ps(ys, y);
+		_mm_storeu_ps(velYs, velY);
+		_mm_storeu_ps(lifes, life);
+
+		for(int lane = 0; lane < 4; lane++)
+		{
+			if(mask & (1 << lane))
+			{
+				mX[kept] = xs[lane];
+				mY[kept] = ys[lane];
+				mVelX[kept] = mVelX[i + lane];
+				mVelY[kept] = velYs[lane];
+				mLife[kept] = lifes[lane];
+				mColor[kept] = mColor[i + lane];
+				mSprite[kept] = mSprite[i + lane];
+				kept++;
+			}
+		}
+	}
+
+	mSize = updateRange(i, kept, seconds);
+}
+
+const char *particleUpdatePath()
+{
+	return "SSE2";
+}
+
+#else
+
+void particlepool::update( float seconds )
+{
+	TRACE_ZONE( "particles" );
+	updateScalar(seconds);
+}
+
+const char *particleUpdatePath()
+{
+	return "scalar";
+}
+
+#endif
+
+//Uniform in lo to hi
+static float randomRange( unsigned int &random, float lo, float hi )
+{
+	random = random * 1664525u + 1013904223u;
+	return lo + (hi - lo) * ((random >> 8) / 16777216.0f);
+}
+
+void spawnBrickBurst( particlepool &pool, const brick &b, unsigned int &random )
+{
+	const SimRect &r = b.brickRect;
+
+	//Away from the side the ball came in by: a hit on the bottom throws debris up
+	float awayX = b.sidehit == LEFT ? 1.0f : b.sidehit == RIGHT ? -1.0f : 0.0f;
+	float awayY = b.sidehit == TOP ? 1.0f : b.sidehit == BOTTOM ? -1.0f : 0.0f;
+
+	for(int n = 0; n < debrisPerBrick; n++)
+	{
+		float x = r.x + randomRange(random, 0.0f, (float)r.w);
+		float y = r.y + randomRange(random, 0.0f, (float)r.h);
+		float speed = randomRange(random, 60.0f, 260.0f);
+		float velX = awayX * speed + randomRange(random, -120.0f, 120.0f);
+		float velY = awayY * speed + randomRange(random, -160.0f, 40.0f);
+		pool.spawn(x, y, velX, velY, randomRange(random, 0.6f, 1.2f), 0xFFFFFFFFu, b.bricktype);
+	}
+
+	//Sparks fly fast and die young from the middle of the side that was hit
+	float hitX = r.x + r.w / 2 - awayX * r.w / 2;
+	float hitY = r.y + r.h / 2 - awayY * r.h / 2;
+	for(int n = 0; n < sparksPerBrick; n++)
+	{
+		float velX = randomRange(random, -400.0f, 400.0f) - awayX * 200.0f;
+		float velY = randomRange(random, -400.0f, 200.0f) - awayY * 200.0f;
+		pool.spawn(hitX, hitY, velX, velY, randomRange(random, 0.2f, 0.4f), 0xFFE070FFu, particleSpark);
+	}
+}
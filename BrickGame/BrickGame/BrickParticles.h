@@ -0,0 +1,84 @@
+/*Particles for brick debris and sparks. Plain C++, no SDL.
+
+particlepool holds every particle in one fixed block of arrays, one array per
+field, allocated once. There are no particle objects and no free list. update
+moves each live particle and drops the dead ones in the same pass, writing the
+survivors back down over them in order, so live particles stay packed at the
+front and the arrays are only ever read and written front to back.
+
+The update kernel handles eight particles at a time with AVX2 or four with
+SSE2, picked at build time like the batch collision kernel.
+
+Particles are only for show. They never touch the game state, so they are
+stepped once per drawn frame with the frame's time, not per tick.*/
+
+#pragma once
+
+#include "BrickSim.h"
+
+//Particles the game's pool holds, spawning stops while it is full
+const int particleCapacity = 1 << 17;
+
+//Downward pull in pixels per second squared
+const float particleGravity = 900.0f;
+
+//Sprite numbers below numBrickTypes are a chip of that brick's sprite, this one a spark from the ball
+const int particleSpark = numBrickTypes;
+
+class particlepool
+{
+public:
+	explicit particlepool( int capacity = particleCapacity );
+	~particlepool();
+
+	//Removes every particle
+	void clear();
+
+	//Adds one particle, dropped if the pool is full. Returns false if it was dropped.
+	//Velocity is in pixels per second, life in seconds and color is 0xRRGGBBAA.
+	bool spawn( float x, float y, float velX, float velY, float life, unsigned int color, int sprite );
+
+	//Moves every particle by seconds and removes those whose life ran out or that fell below floorY
+	void update( float seconds );
+
+	//The same with plain C++ only, gives the same particles
+	void updateScalar( float seconds );
+
+	int size() const;
+	int capacity() const;
+
+	//Live particles, size() of each
+	const float *xs() const { return mX; }
+	const float *ys() const { return mY; }
+	const float *velXs() const { return mVelX; }
+	const float *velYs() const { return mVelY; }
+	const float *lives() const { return mLife; }
+	const unsigned int *colors() const { return mColor; }
+	const int *sprites() const { return mSprite; }
+
+	//Particles below this are removed, the bottom of the play area by default
+	float floorY;
+
+private:
+	particlepool( const particlepool & );
+	particlepool &operator=( const particlepool & );
+
+	//Moves particles first to size() - 1 and packs the survivors down from index kept.
+	//Returns the new size.
+	int updateRange( int first, int kept, float seconds );
+
+	//One aligned block holding the arrays back to back
+	float *mBlock;
+	float *mX, *mY, *mVelX, *mVelY, *mLife;
+	unsigned int *mColor;
+	int *mSprite;
+	int mSize;
+	int mCapacity;
+};
+
+//Debris from a destroyed brick's sprite, thrown away from the side the ball hit, and a few
+//sparks. random is the caller's generator state, advanced for each particle.
+void spawnBrickBurst( particlepool &pool, const brick &b, unsigned int &random );
+
+//Which instruction set particlepool::update was built with
+const char *particleUpdatePath();
@@ -0,0 +1,229 @@
+/*Frame phase timing.*/
+
+#include "BrickProfile.h"
+#include <stdio.h>
+#include <string.h>
+
+timehistogram::timehistogram()
+{
+	window = 0;
+	memset( mCounts, 0, sizeof( mCounts ) );
+	mCount = 0;
+	mSum = 0;
+	mMax = 0;
+	mNext = 0;
+}
+
+void timehistogram::add( double micros )
+{
+	if( micros < 0 )
+	{
+		micros = 0;
+	}
+
+	//Times in the window are kept as floats, so count the same value they will be taken out as
+	if( window > 0 )
+	{
+		micros = (float)micros;
+	}
+
+	if( window > 0 )
+	{
+		if( (int)mRecent.size() < window )
+		{
+			mRecent.push_back( (float)micros );
+		}
+		else
+		{
+			//The oldest time drops out of the counts as the new one takes its place
+			float oldest = mRecent[mNext];
+			mCounts[bucketOf( oldest )]--;
+			mCount--;
+			mSum -= oldest;
+
+			mRecent[mNext] = (float)micros;
+			mNext = ( mNext + 1 ) % window;
+		}
+	}
+
+	mCounts[bucketOf( micros )]++;
+	mCount++;
+	mSum += micros;
+	if( micros > mMax )
+	{
+		mMax = micros;
+	}
+}
+
+double timehistogram::percentile( double p ) const
+{
+	if( mCount == 0 )
+	{
+		return 0;
+	}
+
+	long long wanted = (long long)( p * mCount + 0.5 );
+	if( wanted < 1 )
+	{
+		wanted = 1;
+	}
+
+	long long seen = 0;
+	for( int b = 0; b < numBuckets; b++ )
+	{
+		seen += mCounts[b];
+		if( seen >= wanted )
+		{
+			return bucketMiddle( b );
+		}
+	}
+	return bucketMiddle( numBuckets - 1 );
+}
+
+double timehistogram::max() const
+{
+	if( window <= 0 )
+	{
+		return mMax;
+	}
+
+	//The largest time may have left the window, so look through what is still in it
+	double largest = 0;
+	for( int i = 0; i < (int)mRecent.size(); i++ )
+	{
+		if( mRecent[i] > largest )
+		{
+			largest = mRecent[i];
+		}
+	}
+	return largest;
+}
+
+double timehistogram::mean() const
+{
+	return mCount > 0 ? mSum / mCount : 0;
+}
+
+long long timehistogram::count() const
+{
+	return mCount;
+}
+
+int timehistogram::bucketOf( double micros )
+{
+	long long v = (long long)micros;
+
+	//Below 16us every microsecond has a bucket
+	if( v < 16 )
+	{
+		return (int)v;
+	}
+
+	//Above that, the power of two and the next three bits pick the bucket
+	int e = 4;
+	while( e < 63 && ( v >> ( e + 1 ) ) != 0 )
+	{
+		e++;
+	}
+	int bucket = 16 + ( e - 4 ) * 8 + (int)( ( v >> ( e - 3 ) ) & 7 );
+
+	return bucket < numBuckets ? bucket : numBuckets - 1;
+}
+
+double timehistogram::bucketMiddle( int bucket )
+{
+	//The first buckets hold whole microseconds
+	if( bucket < 16 )
+	{
+		return bucket;
+	}
+
+	int e = ( bucket - 16 ) / 8 + 4;
+	int sub = ( bucket - 16 ) % 8;
+	double width = (double)( 1LL << ( e - 3 ) );
+	return ( 8 + sub ) * width + width / 2;
+}
+
+frameprofiler::frameprofiler()
+{
+	for( int p = 0; p < numFramePhases; p++ )
+	{
+		mFrame[p] = 0;
+		mRecent[p].window = frameWindow;
+	}
+	mRecentLatency.window = frameWindow;
+}
+
+void frameprofiler::add( framephase phase, double seconds )
+{
+	mFrame[phase] += seconds;
+}
+
+void frameprofiler::endFrame()
+{
+	for( int p = 0; p < numFramePhases; p++ )
+	{
+		mRecent[p].add( mFrame[p] * 1000000.0 );
+		mTotal[p].add( mFrame[p] * 1000000.0 );
+		mFrame[p] = 0;
+	}
+}
+
+const timehistogram& frameprofiler::recent( framephase phase ) const
+{
+	return mRecent[phase];
+}
+
+const timehistogram& frameprofiler::total( framephase phase ) const
+{
+	return mTotal[phase];
+}
+
+void frameprofiler::addLatency( double seconds )
+{
+	mRecentLatency.add( seconds * 1000000.0 );
+	mTotalLatency.add( seconds * 1000000.0 );
+}
+
+const timehistogram& frameprofiler::recentLatency() const
+{
+	return mRecentLatency;
+}
+
+const timehistogram& frameprofiler::totalLatency() const
+{
+	return mTotalLatency;
+}
+
+const char* frameprofiler::phaseName( framephase phase )
+{
+	static const char* names[numFramePhases] = { "wait", "events", "setup", "move", "remove", "bricks", "render", "hud", "present", "frame" };
+	return names[phase];
+}
+
+bool frameprofiler::writeCSV( const char* path ) const
+{
+	FILE* file = fopen( path, "w" );
+	if( file == NULL )
+	{
+		printf( "Unable to create %s!\n", path );
+		return false;
+	}
+
+	fprintf( file, "phase,p50_ms,p95_ms,p99_ms,max_ms,mean_ms,frames\n" );
+	for( int p = 0; p <= numFramePhases; p++ )
+	{
+		//Latency goes last, counted over the frames that had input
+		const timehistogram& h = p < numFramePhases ? mTotal[p] : mTotalLatency;
+		fprintf( file, "%s,%.4f,%.4f,%.4f,%.4f,%.4f,%lld\n", p < numFramePhases ? phaseName( (framephase)p ) : "latency",
+			h.percentile( 0.50 ) / 1000, h.percentile( 0.95 ) / 1000, h.percentile( 0.99 ) / 1000,
+			h.max() / 1000, h.mean() / 1000, h.count() );
+	}
+
+	if( fclose( file ) != 0 )
+	{
+		printf( "Unable to write %s!\n", path );
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,97 @@
+/*Frame phase timing. Plain C++, no SDL: the caller measures, this keeps count.
+
+Each phase's time is summed over the frame, then goes into two histograms:
+one over the last frameWindow frames for the on-screen overlay and one over
+the whole run for the CSV written on exit. Buckets are log scaled, eight to
+each doubling above 16 microseconds, so percentiles are within about 6% and
+adding a frame costs the same however long the game runs.
+
+Input latency is kept the same way in histograms of its own, one count per
+frame that had input in it.*/
+
+#pragma once
+
+#include <vector>
+
+//The parts of a frame that are timed. Setup is clearing the screen and working out the ticks due,
+//bricks is drawing or queueing the brick field and render the rest of the play area.
+enum framephase
+{
+	PHASE_WAIT, PHASE_EVENTS, PHASE_SETUP, PHASE_MOVE, PHASE_REMOVE, PHASE_BRICKS, PHASE_RENDER, PHASE_HUD, PHASE_PRESENT, PHASE_FRAME, numFramePhases
+};
+
+//Frames the rolling histograms cover
+const int frameWindow = 1024;
+
+//Microsecond times bucketed on a log scale
+class timehistogram
+{
+public:
+	timehistogram();
+
+	//Counts a time, and if window is above 0 forgets the oldest once there are window of them
+	void add( double micros );
+
+	//Time below which fraction p of the counted times fall, in microseconds
+	double percentile( double p ) const;
+
+	double max() const;
+	double mean() const;
+	long long count() const;
+
+	//Limits the histogram to the last window times, 0 keeps every time
+	int window;
+
+	static const int numBuckets = 176;
+
+private:
+	static int bucketOf( double micros );
+
+	//Middle of a bucket's range, what a percentile falling in it reports
+	static double bucketMiddle( int bucket );
+
+	long long mCounts[numBuckets];
+	long long mCount;
+	double mSum;
+	double mMax;
+
+	//Times still in the window, oldest at mNext once it is full
+	std::vector<float> mRecent;
+	int mNext;
+};
+
+class frameprofiler
+{
+public:
+	frameprofiler();
+
+	//Adds seconds to phase for the frame in progress, a phase may be timed several times a frame
+	void add( framephase phase, double seconds );
+
+	//Puts the frame's phase times into the histograms and starts the next frame
+	void endFrame();
+
+	//Histograms of the last frameWindow frames and of the whole run
+	const timehistogram& recent( framephase phase ) const;
+	const timehistogram& total( framephase phase ) const;
+
+	//Counts the time from a frame's oldest input event to its present returning
+	void addLatency( double seconds );
+
+	//Latency histograms of the last frameWindow frames with input and of the whole run
+	const timehistogram& recentLatency() const;
+	const timehistogram& totalLatency() const;
+
+	//Short lowercase name of a phase
+	static const char* phaseName( framephase phase );
+
+	//Writes p50, p95, p99, max, mean and count of every phase and of latency over the whole run, in milliseconds
+	bool writeCSV( const char* path ) const;
+
+private:
+	double mFrame[numFramePhases];
+	timehistogram mRecent[numFramePhases];
+	timehistogram mTotal[numFramePhases];
+	timehistogram mRecentLatency;
+	timehistogram mTotalLatency;
+};
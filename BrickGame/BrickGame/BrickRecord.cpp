@@ -0,0 +1,254 @@
+/*Input recording and replay.*/
+
+#include "BrickRecord.h"
+#include <stdio.h>
+
+//Bump when the file layout or the game rules change, old recordings won't replay the same.
+//Version 3 added brick types and hit points to the checkpoint hash, older checkpoints can't match.
+const unsigned int replayVersion = 3;
+
+//Unsigned LEB128, seven bits a byte with the top bit set on all but the last
+static void putVarint( std::vector<unsigned char> &out, unsigned long long value )
+{
+	while( value >= 0x80 )
+	{
+		out.push_back( (unsigned char)( value | 0x80 ) );
+		value >>= 7;
+	}
+	out.push_back( (unsigned char)value );
+}
+
+static bool getVarint( const std::vector<unsigned char> &in, size_t &pos, unsigned long long &value )
+{
+	value = 0;
+	for( int shift = 0; shift < 64 && pos < in.size(); shift += 7 )
+	{
+		unsigned char byte = in[pos++];
+		value |= (unsigned long long)( byte & 0x7F ) << shift;
+		if( !( byte & 0x80 ) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+replaylog::replaylog()
+{
+	seed = 1;
+	tickRate = referenceTickRate;
+	ballSpeed = ball::ball_VEL;
+	ticks = 0;
+	mRolling = hashBasis;
+}
+
+void replaylog::begin( const brickgame &game )
+{
+	seed = game.seed;
+	tickRate = game.tickRate;
+	ballSpeed = game.ballSpeed;
+	events.clear();
+	checkpoints.clear();
+	ticks = 0;
+	mRolling = hashBasis;
+}
+
+void replaylog::input( gameinput input, bool pressed )
+{
+	replayevent e = { ticks, input, pressed };
+	events.push_back( e );
+}
+
+void replaylog::ticked( const brickgame &game )
+{
+	mRolling = hashValue( mRolling, game.stateHash() );
+	ticks++;
+
+	if( ticks % replayCheckInterval == 0 )
+	{
+		checkpoints.push_back( mRolling );
+	}
+}
+
+bool replaylog::save( const char* path ) const
+{
+	std::vector<unsigned char> out;
+	out.push_back( 'B' );
+	out.push_back( 'R' );
+	out.push_back( 'E' );
+	out.push_back( 'C' );
+
+	putVarint( out, replayVersion );
+	putVarint( out, seed );
+	putVarint( out, tickRate );
+	putVarint( out, ballSpeed );
+	putVarint( out, level.size() );
+	out.insert( out.end(), level.begin(), level.end() );
+	putVarint( out, replayCheckInterval );
+
+	putVarint( out, events.size() );
+	long long last = 0;
+	for( size_t i = 0; i < events.size(); i++ )
+	{
+		putVarint( out, events[i].tick - last );
+		putVarint( out, events[i].input * 2 + ( events[i].pressed ? 1 : 0 ) );
+		last = events[i].tick;
+	}
+
+	putVarint( out, ticks );
+
+	//The final hash goes last, unless the recording ended on a checkpoint anyway
+	std::vector<unsigned long long> hashes = checkpoints;
+	if( ticks % replayCheckInterval != 0 )
+	{
+		hashes.push_back( mRolling );
+	}
+
+	putVarint( out, hashes.size() );
+	for( size_t i = 0; i < hashes.size(); i++ )
+	{
+		for( int byte = 0; byte < 8; byte++ )
+		{
+			out.push_back( (unsigned char)( hashes[i] >> ( byte * 8 ) ) );
+		}
+	}
+
+	FILE* file = fopen( path, "wb" );
+	if( file == NULL )
+	{
+		printf( "Unable to create recording %s!\n", path );
+		return false;
+	}
+
+	bool success = fwrite( out.data(), 1, out.size(), file ) == out.size();
+	if( fclose( file ) != 0 || !success )
+	{
+		printf( "Unable to write recording %s!\n", path );
+		return false;
+	}
+
+	return true;
+}
+
+bool replaylog::load( const char* path )
+{
+	FILE* file = fopen( path, "rb" );
+	if( file == NULL )
+	{
+		printf( "Unable to open recording %s!\n", path );
+		return false;
+	}
+
+	std::vector<unsigned char> in;
+	unsigned char buffer[4096];
+	size_t got;
+	while( ( got = fread( buffer, 1, sizeof( buffer ), file ) ) > 0 )
+	{
+		in.insert( in.end(), buffer, buffer + got );
+	}
+	fclose( file );
+
+	if( in.size() < 4 || in[0] != 'B' || in[1] != 'R' || in[2] != 'E' || in[3] != 'C' )
+	{
+		printf( "%s is not a recording!\n", path );
+		return false;
+	}
+
+	size_t pos = 4;
+	unsigned long long version = 0, value = 0, interval = 0, count = 0;
+	bool ok = getVarint( in, pos, version );
+	if( ok && version != replayVersion )
+	{
+		printf( "Recording %s is version %llu, this build replays version %u!\n", path, version, replayVersion );
+		return false;
+	}
+
+	ok = ok && getVarint( in, pos, value );
+	seed = (unsigned int)value;
+	ok = ok && getVarint( in, pos, value );
+	tickRate = (int)value;
+	ok = ok && getVarint( in, pos, value );
+	ballSpeed = (int)value;
+	level.clear();
+	ok = ok && getVarint( in, pos, value ) && value <= in.size() - pos;
+	if( ok )
+	{
+		level.assign( in.begin() + pos, in.begin() + pos + value );
+		pos += value;
+	}
+	ok = ok && getVarint( in, pos, interval ) && interval == replayCheckInterval;
+
+	events.clear();
+	ok = ok && getVarint( in, pos, count );
+	long long tick = 0;
+	for( unsigned long long i = 0; ok && i < count; i++ )
+	{
+		unsigned long long delta = 0, code = 0;
+		ok = getVarint( in, pos, delta ) && getVarint( in, pos, code ) && code / 2 <= INPUT_LAUNCH;
+		tick += delta;
+		replayevent e = { tick, (gameinput)( code / 2 ), ( code & 1 ) != 0 };
+		events.push_back( e );
+	}
+
+	ok = ok && getVarint( in, pos, value );
+	ticks = (long long)value;
+
+	checkpoints.clear();
+	ok = ok && getVarint( in, pos, count ) && in.size() - pos == count * 8;
+	for( unsigned long long i = 0; ok && i < count; i++ )
+	{
+		unsigned long long hash = 0;
+		for( int byte = 0; byte < 8; byte++ )
+		{
+			hash |= (unsigned long long)in[pos++] << ( byte * 8 );
+		}
+		checkpoints.push_back( hash );
+	}
+
+	if( !ok )
+	{
+		printf( "Recording %s is damaged!\n", path );
+		return false;
+	}
+
+	mRolling = hashBasis;
+	return true;
+}
+
+bool replaylog::replay( brickgame &game, long long &failTick ) const
+{
+	game.seed = seed;
+	game.tickRate = tickRate;
+	game.ballSpeed = ballSpeed;
+	game.reset();
+
+	unsigned long long rolling = hashBasis;
+	size_t next = 0;
+	size_t checkpoint = 0;
+
+	for( long long t = 0; t < ticks; t++ )
+	{
+		//Inputs went in between ticks, before this one ran
+		while( next < events.size() && events[next].tick == t )
+		{
+			game.handleInput( events[next].input, events[next].pressed );
+			next++;
+		}
+
+		game.step();
+		rolling = hashValue( rolling, game.stateHash() );
+
+		if( ( ( t + 1 ) % replayCheckInterval == 0 || t + 1 == ticks ) && checkpoint < checkpoints.size() )
+		{
+			if( rolling != checkpoints[checkpoint] )
+			{
+				failTick = t + 1;
+				return false;
+			}
+			checkpoint++;
+		}
+	}
+
+	failTick = ticks;
+	return checkpoint == checkpoints.size();
+}
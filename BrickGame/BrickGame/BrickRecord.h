@@ -0,0 +1,71 @@
+/*Input recording and replay. Plain C++, no SDL.
+
+A game is fully determined by its seed, tick rate, ball speed, level and the
+inputs fed to it between ticks, so that is all a recording holds. Every tick the
+recorder folds the game's stateHash into a rolling hash and keeps it every
+replayCheckInterval ticks. A replay runs the inputs on a fresh game with no
+window and checks the rolling hash at each of those ticks, so the first tick
+where the game plays differently is caught within one interval.
+
+File layout: the magic "BREC", then unsigned LEB128 varints for the version,
+seed, tick rate, ball speed, level path length and its bytes, check interval and event count, one pair of
+varints per event (ticks since the previous event, input * 2 + pressed), the
+tick count, then the checkpoint count and the checkpoints as 8 byte little
+endian hashes, the last one being the hash after the final tick.*/
+
+#pragma once
+
+#include "BrickSim.h"
+#include <string>
+#include <vector>
+
+//Ticks between stored rolling hashes
+const int replayCheckInterval = 64;
+
+//One press or release, applied before tick runs
+struct replayevent
+{
+	long long tick;
+	gameinput input;
+	bool pressed;
+};
+
+class replaylog
+{
+public:
+	replaylog();
+
+	//Starts an empty recording of game as it stands now
+	void begin( const brickgame &game );
+
+	//Records an input fed to the game before the next tick
+	void input( gameinput input, bool pressed );
+
+	//Call after every tick of the recorded game
+	void ticked( const brickgame &game );
+
+	//Writes or reads the varint encoded file, printing the reason for any failure
+	bool save( const char* path ) const;
+	bool load( const char* path );
+
+	//Plays the recording on game, which is reset first. Returns false at the first
+	//checkpoint whose hash differs, with failTick the tick it was taken after.
+	bool replay( brickgame &game, long long &failTick ) const;
+
+	unsigned int seed;
+	int tickRate;
+	int ballSpeed;
+
+	//Path of the level played, empty for the built in field. Whoever replays
+	//loads it and points the game's level at it before calling replay.
+	std::string level;
+
+	std::vector<replayevent> events;
+	long long ticks;
+
+	//Rolling hash every replayCheckInterval ticks and after the last tick
+	std::vector<unsigned long long> checkpoints;
+
+private:
+	unsigned long long mRolling;
+};
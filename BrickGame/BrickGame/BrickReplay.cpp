@@ -0,0 +1,135 @@
+/*Headless replay of recorded games. Runs a recording made with the game's
+--record option as fast as the simulation goes and checks the game plays out
+exactly as it did when recorded. Exits with 1 if it doesn't, so recordings
+double as regression tests.
+
+Usage: BrickReplay file [repeats]
+       BrickReplay --record file [ticks] [seed] [level]
+
+--record writes a recording without a window: random presses and releases
+of left, right and launch for the given number of ticks, on the built in
+field or the given level. A recording's level is loaded from the path it was
+recorded with, so replay from the directory the game ran in.*/
+
+#include "BrickRecord.h"
+#include "BrickLevel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+//Plays ticks ticks of random input on a game and saves them to path
+int record( const char* path, long long ticks, unsigned int seed, const char* levelPath )
+{
+	bricklevel level;
+	brickgame game;
+	if(levelPath != NULL)
+	{
+		if(!level.load(levelPath))
+		{
+			return 1;
+		}
+		game.level = &level;
+	}
+	game.seed = seed;
+	game.reset();
+
+	replaylog log;
+	log.begin(game);
+	log.level = levelPath != NULL ? levelPath : "";
+
+	unsigned int random = seed;
+	bool held[INPUT_LAUNCH + 1] = { false, false, false };
+
+	for(long long t = 0; t < ticks; t++)
+	{
+		//About one press or release every 16 ticks
+		random = random * 1664525u + 1013904223u;
+		if((random >> 8) % 16 == 0)
+		{
+			gameinput input = (gameinput)((random >> 16) % (INPUT_LAUNCH + 1));
+			held[input] = !held[input];
+			log.input(input, held[input]);
+			game.handleInput(input, held[input]);
+		}
+
+		game.step();
+		log.ticked(game);
+	}
+
+	if(!log.save(path))
+	{
+		return 1;
+	}
+
+	printf("recorded %lld ticks, %d events, score %d\n", ticks, (int)log.events.size(), game.gamescore);
+	return 0;
+}
+
+int main( int argc, char* args[] )
+{
+	if(argc > 2 && strcmp(args[1], "--record") == 0)
+	{
+		long long ticks = argc > 3 ? atoll(args[3]) : 100000;
+		unsigned int seed = argc > 4 ? (unsigned int)strtoul(args[4], NULL, 10) : 1;
+		return record(args[2], ticks, seed, argc > 5 ? args[5] : NULL);
+	}
+
+	if(argc < 2)
+	{
+		printf("Usage: BrickReplay file [repeats]\n       BrickReplay --record file [ticks] [seed] [level]\n");
+		return 1;
+	}
+
+	replaylog log;
+	if(!log.load(args[1]))
+	{
+		return 1;
+	}
+
+	int repeats = argc > 2 ? atoi(args[2]) : 1;
+	if(repeats < 1)
+	{
+		repeats = 1;
+	}
+
+	bricklevel level;
+	brickgame game;
+	if(!log.level.empty())
+	{
+		if(!level.load(log.level.c_str()))
+		{
+			return 1;
+		}
+		game.level = &level;
+		printf("level: %s\n", log.level.c_str());
+	}
+
+	printf("seed: %u\n", log.seed);
+	printf("tick rate: %d\n", log.tickRate);
+	printf("ticks: %lld\n", log.ticks);
+	printf("events: %d\n", (int)log.events.size());
+
+	long long failTick = 0;
+	bool matched = true;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(int r = 0; r < repeats && matched; r++)
+	{
+		matched = log.replay(game, failTick);
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if(!matched)
+	{
+		printf("DIVERGED: state differs from the recording by tick %lld\n", failTick);
+		return 1;
+	}
+
+	printf("score: %d\n", game.gamescore);
+	printf("seconds: %.3f\n", seconds);
+	printf("ticks/s: %.0f\n", seconds > 0 ? log.ticks * repeats / seconds : 0.0);
+	printf("replay matches\n");
+
+	return 0;
+}
@@ -0,0 +1,65 @@
+/*Lock-free single producer, single consumer ring buffer. One thread pushes and
+one other thread pops, neither ever blocks or takes a lock. Plain C++11, no SDL.*/
+
+#pragma once
+
+#include <atomic>
+
+//Capacity must be a power of two, the ring holds up to Capacity items
+template<typename T, unsigned int Capacity>
+class spscring
+{
+	static_assert( ( Capacity & ( Capacity - 1 ) ) == 0, "spscring capacity must be a power of two" );
+
+public:
+	spscring() : mHead( 0 ), mTail( 0 ) {}
+
+	//Producer only. Returns false, dropping item, when the ring is full.
+	bool push( const T& item )
+	{
+		unsigned int head = mHead.load( std::memory_order_relaxed );
+		if( head - mTail.load( std::memory_order_acquire ) == Capacity )
+		{
+			return false;
+		}
+
+		mItems[head & ( Capacity - 1 )] = item;
+
+		//Publishes the item to the consumer
+		mHead.store( head + 1, std::memory_order_release );
+		return true;
+	}
+
+	//Consumer only. Returns false when the ring is empty.
+	bool pop( T& item )
+	{
+		unsigned int tail = mTail.load( std::memory_order_relaxed );
+		if( tail == mHead.load( std::memory_order_acquire ) )
+		{
+			return false;
+		}
+
+		item = mItems[tail & ( Capacity - 1 )];
+
+		//Hands the slot back to the producer
+		mTail.store( tail + 1, std::memory_order_release );
+		return true;
+	}
+
+	//Items waiting, exact only when called from the producer or consumer thread
+	unsigned int size() const
+	{
+		return mHead.load( std::memory_order_acquire ) - mTail.load( std::memory_order_acquire );
+	}
+
+private:
+	T mItems[Capacity];
+
+	//Head and tail a cache line apart from each other and the items so the two threads don't
+	//fight over one. Padded by hand, new doesn't honor alignas( 64 ) before C++17.
+	char mItemsPad[64];
+	std::atomic<unsigned int> mHead;
+	char mHeadPad[64 - sizeof( std::atomic<unsigned int> )];
+	std::atomic<unsigned int> mTail;
+	char mTailPad[64 - sizeof( std::atomic<unsigned int> )];
+};
@@ -0,0 +1,1417 @@
+/*BrickGame simulation core. Game rules only, no SDL.*/
+
+#include "BrickSim.h"
+#include "BrickTrace.h"
+#include "BrickLevel.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+
+paddle::paddle()
+{
+    //Initialize the paddle at the bottom middle
+	mPosX = SCREEN_WIDTH/2 - (paddle_width/2); // in the middle
+	mPosY = SCREEN_HEIGHT - SCOREBOARD_HEIGHT - paddle_height; // bottom of the screen minus the height of the paddle
+
+    //Initialize the velocity
+    mVelX = 0;
+    mVelY = 0;
+	mRemX = 0;
+	mAxisVel = 0;
+	mNumTimed = 0;
+
+	mPaddleCollider.h = paddle_height;
+	mPaddleCollider.w = paddle_width;
+	shiftColliders();
+}
+
+void paddle::handleInput( gameinput input, bool pressed )
+{
+    //If a key was pressed
+	if( pressed )
+    {
+        //Adjust the velocity
+        switch( input )
+        {
+            case INPUT_LEFT: mVelX -= paddle_vel; break;
+            case INPUT_RIGHT: mVelX += paddle_vel; break;
+            default: break;
+        }
+    }
+    //If a key was released
+    else
+    {
+        //Adjust the velocity
+        switch( input )
+        {
+            case INPUT_LEFT: mVelX += paddle_vel; break;
+            case INPUT_RIGHT: mVelX -= paddle_vel; break;
+            default: break;
+        }
+    }
+}
+
+void paddle::steer( int direction )
+{
+	mVelX = direction < 0 ? -paddle_vel : direction > 0 ? paddle_vel : 0;
+}
+
+bool paddle::queueTimed( const timedpaddleinput& input )
+{
+	if( mNumTimed == paddleMaxTimed )
+	{
+		applyControl( input );
+		return false;
+	}
+
+	mTimed[mNumTimed++] = input;
+	return true;
+}
+
+void paddle::applyControl( const timedpaddleinput& input )
+{
+	switch( input.control )
+	{
+		case PADDLE_PRESS: handleInput( input.input, true ); break;
+		case PADDLE_RELEASE: handleInput( input.input, false ); break;
+		case PADDLE_AXIS: mAxisVel = (int)( input.value * paddle_vel * 256 ); break;
+		case PADDLE_NUDGE:
+			//Straight to the new place, stopping at the wall
+			mPosX += (int)( input.value < 0 ? input.value - 0.5f : input.value + 0.5f );
+			mPosX = mPosX < 0 ? 0 : mPosX + paddle_width > SCREEN_WIDTH ? SCREEN_WIDTH - paddle_width : mPosX;
+			shiftColliders();
+			break;
+	}
+}
+
+void paddle::move( int tickRate )
+{
+	//Keys alone, with nothing part way through the tick, move as they always have
+	if( mNumTimed > 0 || mAxisVel != 0 )
+	{
+		moveTimed( tickRate );
+		return;
+	}
+
+	int stepX = stepDistance( mVelX, tickRate, mRemX );
+
+    //Move the paddle left or right
+    mPosX += stepX;
+	shiftColliders();
+
+    //If the paddle went too far to the left or right
+    if( ( mPosX < 0 ) || ( mPosX + paddle_width> SCREEN_WIDTH ) )
+    {
+        //Move back
+        mPosX -= stepX;
+		mRemX = 0;
+    }
+}
+
+void paddle::moveTimed( int tickRate )
+{
+	//Distance in 256ths of a pixel per reference tick times substeps, summed piece by piece
+	//between the inputs. Nudges move the paddle by their pixels whenever they came.
+	long long distance = 0;
+	int nudge = 0;
+	int last = 0;
+	for( int i = 0; i < mNumTimed; i++ )
+	{
+		const timedpaddleinput& input = mTimed[i];
+		int at = input.at < last ? last : input.at > paddleSubsteps ? paddleSubsteps : input.at;
+		distance += (long long)( mVelX * 256 + mAxisVel ) * ( at - last );
+		last = at;
+
+		if( input.control == PADDLE_NUDGE )
+		{
+			nudge += (int)( input.value < 0 ? input.value - 0.5f : input.value + 0.5f );
+		}
+		else
+		{
+			applyControl( input );
+		}
+	}
+	distance += (long long)( mVelX * 256 + mAxisVel ) * ( paddleSubsteps - last );
+	mNumTimed = 0;
+
+	//The same sum stepDistance does, with the remainder kept in its units
+	long long scale = 256LL * paddleSubsteps;
+	long long total = distance * referenceTickRate + mRemX * scale;
+	int stepX = (int)( total / ( scale * tickRate ) );
+	mRemX = (int)( ( total % ( scale * tickRate ) ) / scale );
+
+	//Analog and mouse control stop at the wall rather than short of it
+	mPosX += stepX + nudge;
+	if( mPosX < 0 || mPosX + paddle_width > SCREEN_WIDTH )
+	{
+		mPosX = mPosX < 0 ? 0 : SCREEN_WIDTH - paddle_width;
+		mRemX = 0;
+	}
+	shiftColliders();
+}
+
+void paddle::shiftColliders()
+{
+	mPaddleCollider.x = mPosX;
+	mPaddleCollider.y = mPosY;
+}
+
+brick::brick()
+{
+	brickRect.x = 0;
+	brickRect.y = 0;
+	brickRect.h = 0;
+	brickRect.w = 0;
+	sidehit = NONE;
+	hitbyball = false;
+	bricktype = 0;
+	hitpoints = 1;
+}
+
+void brick::arrange(int posX, int posY)
+{
+	brickRect.x = posX;
+	brickRect.y = posY;
+	brickRect.w = brick_width;
+	brickRect.h = brick_height;
+}
+
+ball::ball()
+{
+    //Initialize the offsets
+	mPosX = -200;
+	mPosY = -200;
+
+	// Set collision circle size
+	mBallCollider.r = ball_WIDTH/2;
+
+    //Initialize the velocity
+    mVelX = 0;
+    mVelY = 0;
+	mRemX = 0;
+	mRemY = 0;
+
+	//// move collider relative to the circle
+	shiftColliders();
+}
+
+void ball::handleInput( gameinput input, bool pressed, bool gameOn, int speed )
+{
+    //If the launch key was pressed before the game started
+	if( pressed && input == INPUT_LAUNCH && !gameOn )
+    {
+		mVelY -= speed;
+		mVelX += speed;
+    }
+}
+
+bool ball::move(const brickfield &gameBricks, const brickgrid &grid, const paddle &gamePaddle, int tickRate)
+{
+	TRACE_ZONE( "ball::move" );
+
+	ballstate s = { mPosX, mPosY, mVelX, mVelY, mRemX, mRemY, mBallCollider.r };
+	brickhandle bricksHit[max_contacts];
+	brickside sidesHit[max_contacts];
+	int numHit;
+	bool hitPaddle = sweepBall( s, gameBricks, grid, &gamePaddle.mPaddleCollider, gamePaddle.mVelX, tickRate, mNearby, bricksHit, sidesHit, numHit );
+
+	mPosX = s.x;
+	mPosY = s.y;
+	mVelX = s.velX;
+	mVelY = s.velY;
+	mRemX = s.remX;
+	mRemY = s.remY;
+	shiftColliders();
+
+	mBricksHit.assign( bricksHit, bricksHit + numHit );
+	mSidesHit.assign( sidesHit, sidesHit + numHit );
+
+	return hitPaddle;
+}
+
+void ball::place(int posX, int posY)
+{
+	mPosX = posX;
+	mPosY = posY;
+	mVelX = 0;
+	mVelY = 0;
+	mRemX = 0;
+	mRemY = 0;
+	shiftColliders();
+}
+
+void ball::launch(int velX, int velY)
+{
+	mVelX = velX;
+	mVelY = velY;
+}
+
+int ball::getVelX() const
+{
+	return mVelX;
+}
+
+int ball::getVelY() const
+{
+	return mVelY;
+}
+
+void ball::shiftColliders()
+{
+	mBallCollider.x = mPosX;
+	mBallCollider.y = mPosY;
+}
+
+brickfield::brickfield()
+{
+	mBlock = NULL;
+	mX = mY = mW = mH = NULL;
+	mSize = 0;
+	mCapacity = 0;
+	reserve(brickBatchWidth);
+}
+
+brickfield::brickfield( const brickfield &other )
+{
+	mBlock = NULL;
+	mX = mY = mW = mH = NULL;
+	mSize = 0;
+	mCapacity = 0;
+	*this = other;
+}
+
+brickfield &brickfield::operator=( const brickfield &other )
+{
+	if(this != &other)
+	{
+		mSize = 0;
+		reserve(other.mCapacity);
+		memcpy(mX, other.mX, other.mCapacity * sizeof(int));
+		memcpy(mY, other.mY, other.mCapacity * sizeof(int));
+		memcpy(mW, other.mW, other.mCapacity * sizeof(int));
+		memcpy(mH, other.mH, other.mCapacity * sizeof(int));
+		for(int i = other.mCapacity; i < mCapacity; i++)
+		{
+			pad(i);
+		}
+		mSize = other.mSize;
+
+		types = other.types;
+		hitPoints = other.hitPoints;
+		hit = other.hit;
+		sides = other.sides;
+
+		mIndexSlot = other.mIndexSlot;
+		mSlotIndex = other.mSlotIndex;
+		mSlotGeneration = other.mSlotGeneration;
+		mLive = other.mLive;
+		mFreeSlots = other.mFreeSlots;
+	}
+	return *this;
+}
+
+brickfield::~brickfield()
+{
+	if(mBlock != NULL)
+	{
+		free(((void**)mBlock)[-1]);
+	}
+}
+
+void brickfield::clear()
+{
+	for(int i = 0; i < mSize; i++)
+	{
+		pad(i);
+	}
+	mSize = 0;
+
+	types.clear();
+	hitPoints.clear();
+	hit.clear();
+	sides.clear();
+
+	//Every slot goes back on the free list with its generation moved on,
+	//so handles from before the clear are stale
+	mIndexSlot.clear();
+	mFreeSlots.clear();
+	for(int slot = mSlotIndex.size() - 1; slot >= 0; slot--)
+	{
+		if(mSlotIndex[slot] >= 0)
+		{
+			mSlotGeneration[slot]++;
+			mSlotIndex[slot] = -1;
+		}
+		mFreeSlots.push_back(slot);
+	}
+	mLive.assign(mLive.size(), 0);
+}
+
+brickhandle brickfield::add( const brick &b )
+{
+	if(mSize == mCapacity)
+	{
+		reserve(mCapacity * 2);
+	}
+
+	int i = mSize++;
+	mX[i] = b.brickRect.x;
+	mY[i] = b.brickRect.y;
+	mW[i] = b.brickRect.w;
+	mH[i] = b.brickRect.h;
+
+	types.push_back(b.bricktype);
+	hitPoints.push_back(b.hitpoints);
+	hit.push_back(b.hitbyball);
+	sides.push_back(b.sidehit);
+
+	return claimSlot(i);
+}
+
+void brickfield::assign( int count, const int *x, const int *y, const int *w, const int *h, const int *type, const int *hp )
+{
+	clear();
+	reserve(count);
+
+	memcpy(mX, x, count * sizeof(int));
+	memcpy(mY, y, count * sizeof(int));
+	memcpy(mW, w, count * sizeof(int));
+	memcpy(mH, h, count * sizeof(int));
+	mSize = count;
+
+	types.assign(type, type + count);
+	hitPoints.assign(hp, hp + count);
+	hit.assign(count, false);
+	sides.assign(count, NONE);
+
+	//The free list hands back slots lowest first after a clear, so brick i gets slot i
+	for(int i = 0; i < count; i++)
+	{
+		claimSlot(i);
+	}
+}
+
+void brickfield::translate( int dx, int dy )
+{
+	//Only live bricks, the padding stays parked
+	for(int i = 0; i < mSize; i++)
+	{
+		mX[i] += dx;
+		mY[i] += dy;
+	}
+}
+
+brickhandle brickfield::claimSlot( int i )
+{
+	//Reuse a free slot or open a new one
+	unsigned int slot;
+	if(!mFreeSlots.empty())
+	{
+		slot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+	else
+	{
+		slot = mSlotIndex.size();
+		mSlotIndex.push_back(-1);
+		mSlotGeneration.push_back(0);
+		if(slot / 64 >= mLive.size())
+		{
+			mLive.push_back(0);
+		}
+	}
+
+	mSlotIndex[slot] = i;
+	mLive[slot / 64] |= 1ull << (slot % 64);
+	mIndexSlot.push_back(slot);
+
+	brickhandle h = { slot, mSlotGeneration[slot] };
+	return h;
+}
+
+bool brickfield::remove( brickhandle h )
+{
+	int i = indexOf(h);
+	if(i < 0)
+	{
+		return false;
+	}
+
+	removeAt(i);
+	return true;
+}
+
+void brickfield::removeAt( int i )
+{
+	//Retire the slot so its handles go stale
+	unsigned int slot = mIndexSlot[i];
+	mSlotIndex[slot] = -1;
+	mSlotGeneration[slot]++;
+	mLive[slot / 64] &= ~(1ull << (slot % 64));
+	mFreeSlots.push_back(slot);
+
+	//Fill the hole with the last brick
+	int last = mSize - 1;
+	if(i != last)
+	{
+		mX[i] = mX[last];
+		mY[i] = mY[last];
+		mW[i] = mW[last];
+		mH[i] = mH[last];
+		types[i] = types[last];
+		hitPoints[i] = hitPoints[last];
+		hit[i] = hit[last];
+		sides[i] = sides[last];
+
+		mIndexSlot[i] = mIndexSlot[last];
+		mSlotIndex[mIndexSlot[i]] = i;
+	}
+
+	pad(last);
+	mSize--;
+
+	types.pop_back();
+	hitPoints.pop_back();
+	hit.pop_back();
+	sides.pop_back();
+	mIndexSlot.pop_back();
+}
+
+bool brickfield::alive( brickhandle h ) const
+{
+	return h.slot < mSlotGeneration.size()
+		&& (mLive[h.slot / 64] >> (h.slot % 64) & 1)
+		&& mSlotGeneration[h.slot] == h.generation;
+}
+
+int brickfield::indexOf( brickhandle h ) const
+{
+	return alive(h) ? mSlotIndex[h.slot] : -1;
+}
+
+int brickfield::indexOfSlot( unsigned int slot ) const
+{
+	return mSlotIndex[slot];
+}
+
+brickhandle brickfield::handleAt( int i ) const
+{
+	unsigned int slot = mIndexSlot[i];
+	brickhandle h = { slot, mSlotGeneration[slot] };
+	return h;
+}
+
+int brickfield::size() const
+{
+	return mSize;
+}
+
+bool brickfield::empty() const
+{
+	return mSize == 0;
+}
+
+brick brickfield::get( int i ) const
+{
+	brick b;
+	b.brickRect = rect(i);
+	b.bricktype = types[i];
+	b.hitpoints = hitPoints[i];
+	b.hitbyball = hit[i];
+	b.sidehit = sides[i];
+	return b;
+}
+
+SimRect brickfield::rect( int i ) const
+{
+	SimRect r = { mX[i], mY[i], mW[i], mH[i] };
+	return r;
+}
+
+void brickfield::reserve( int capacity )
+{
+	//Whole batches only, so the kernel never reads past the end
+	capacity = (capacity + brickBatchWidth - 1) / brickBatchWidth * brickBatchWidth;
+	if(capacity <= mCapacity)
+	{
+		return;
+	}
+
+	//Room for the four arrays plus slack to align the start to 32 bytes.
+	//The original pointer is kept just in front of the aligned block.
+	size_t bytes = 4 * capacity * sizeof(int) + 32 + sizeof(void*);
+	char *raw = (char*)malloc(bytes);
+	size_t aligned = ((size_t)(raw + sizeof(void*)) + 31) & ~(size_t)31;
+	int *block = (int*)aligned;
+	((void**)block)[-1] = raw;
+
+	int *x = block, *y = block + capacity, *w = block + 2 * capacity, *h = block + 3 * capacity;
+	if(mSize > 0)
+	{
+		memcpy(x, mX, mSize * sizeof(int));
+		memcpy(y, mY, mSize * sizeof(int));
+		memcpy(w, mW, mSize * sizeof(int));
+		memcpy(h, mH, mSize * sizeof(int));
+	}
+
+	if(mBlock != NULL)
+	{
+		free(((void**)mBlock)[-1]);
+	}
+
+	mBlock = block;
+	mX = x;
+	mY = y;
+	mW = w;
+	mH = h;
+
+	int oldCapacity = mSize;
+	mCapacity = capacity;
+	for(int i = oldCapacity; i < mCapacity; i++)
+	{
+		pad(i);
+	}
+}
+
+void brickfield::pad( int i )
+{
+	mX[i] = -(1 << 30);
+	mY[i] = -(1 << 30);
+	mW[i] = 0;
+	mH[i] = 0;
+}
+
+brickgrid::brickgrid()
+{
+	mOriginX = 0;
+	mOriginY = 0;
+	mCols = 0;
+	mRows = 0;
+}
+
+void brickgrid::build( const brickfield &gameBricks )
+{
+	mCellStart.clear();
+	mCellCount.clear();
+	mSlots.clear();
+	mCols = 0;
+	mRows = 0;
+
+	if(gameBricks.empty())
+	{
+		return;
+	}
+
+	//Size the grid to the bounds of the field
+	int minX = gameBricks.xs()[0], minY = gameBricks.ys()[0];
+	int maxX = minX, maxY = minY;
+	for(int i = 0; i < gameBricks.size(); i++)
+	{
+		SimRect r = gameBricks.rect(i);
+		minX = std::min(minX, r.x);
+		minY = std::min(minY, r.y);
+		maxX = std::max(maxX, r.x + r.w);
+		maxY = std::max(maxY, r.y + r.h);
+	}
+
+	mOriginX = minX;
+	mOriginY = minY;
+	mCols = (maxX - minX) / brick::brick_width + 1;
+	mRows = (maxY - minY) / brick::brick_height + 1;
+
+	//Count each cell's bricks, lay the cells out back to back, then fill them in
+	mCellCount.assign(mCols * mRows, 0);
+	for(int pass = 0; pass < 2; pass++)
+	{
+		if(pass == 1)
+		{
+			mCellStart.resize(mCols * mRows + 1);
+			mCellStart[0] = 0;
+			for(int c = 0; c < mCols * mRows; c++)
+			{
+				mCellStart[c + 1] = mCellStart[c] + mCellCount[c];
+				mCellCount[c] = 0;
+			}
+			mSlots.resize(mCellStart.back());
+		}
+
+		for(int i = 0; i < gameBricks.size(); i++)
+		{
+			int col0, row0, col1, row1;
+			cellRange(gameBricks.rect(i), col0, row0, col1, row1);
+
+			for(int row = row0; row <= row1; row++)
+			{
+				for(int col = col0; col <= col1; col++)
+				{
+					int c = row * mCols + col;
+					if(pass == 1)
+					{
+						mSlots[mCellStart[c] + mCellCount[c]] = gameBricks.handleAt(i).slot;
+					}
+					mCellCount[c]++;
+				}
+			}
+		}
+	}
+}
+
+void brickgrid::assign( int originX, int originY, int cols, int rows, const unsigned int *cellStart, const unsigned int *slots )
+{
+	mOriginX = originX;
+	mOriginY = originY;
+	mCols = cols;
+	mRows = rows;
+
+	mCellStart.assign(cellStart, cellStart + cols * rows + 1);
+	mSlots.assign(slots, slots + mCellStart.back());
+	mCellCount.resize(cols * rows);
+	for(int c = 0; c < cols * rows; c++)
+	{
+		mCellCount[c] = mCellStart[c + 1] - mCellStart[c];
+	}
+}
+
+void brickgrid::translate( int dx, int dy )
+{
+	//Cells are relative to the origin, so the bricks in them are unchanged
+	mOriginX += dx;
+	mOriginY += dy;
+}
+
+void brickgrid::save( int &originX, int &originY, int &cols, int &rows, std::vector<unsigned int> &cellStart, std::vector<unsigned int> &slots ) const
+{
+	originX = mOriginX;
+	originY = mOriginY;
+	cols = mCols;
+	rows = mRows;
+
+	cellStart.assign(1, 0);
+	slots.clear();
+	for(int c = 0; c < mCols * mRows; c++)
+	{
+		slots.insert(slots.end(), mSlots.begin() + mCellStart[c], mSlots.begin() + mCellStart[c] + mCellCount[c]);
+		cellStart.push_back(slots.size());
+	}
+}
+
+void brickgrid::remove( unsigned int slot, const SimRect &rect )
+{
+	int col0, row0, col1, row1;
+	if(!cellRange(rect, col0, row0, col1, row1))
+	{
+		return;
+	}
+
+	//A brick on the grid's cells fills one, one off them at most a 2x2 block, and each cell holds only a brick or two
+	for(int row = row0; row <= row1; row++)
+	{
+		for(int col = col0; col <= col1; col++)
+		{
+			int c = row * mCols + col;
+			unsigned int *cell = &mSlots[mCellStart[c]];
+			for(int k = 0; k < mCellCount[c]; k++)
+			{
+				if(cell[k] == slot)
+				{
+					cell[k] = cell[--mCellCount[c]];
+					break;
+				}
+			}
+		}
+	}
+}
+
+const std::vector<unsigned int> &brickgrid::query( const SimRect &area )
+{
+	query(area, mFound);
+	return mFound;
+}
+
+void brickgrid::query( const SimRect &area, std::vector<unsigned int> &found ) const
+{
+	found.clear();
+
+	//A circle touching a brick's edge still hits it, so the pixels just outside the area count too
+	SimRect touching = { area.x - 1, area.y - 1, area.w + 2, area.h + 2 };
+	int col0, row0, col1, row1;
+	if(!cellRange(touching, col0, row0, col1, row1))
+	{
+		return;
+	}
+
+	for(int row = row0; row <= row1; row++)
+	{
+		for(int col = col0; col <= col1; col++)
+		{
+			int c = row * mCols + col;
+			found.insert(found.end(), mSlots.begin() + mCellStart[c], mSlots.begin() + mCellStart[c] + mCellCount[c]);
+		}
+	}
+
+	//Bricks straddling cells show up more than once. Ascending slot order keeps hits
+	//resolving in the same order however the field has been compacted.
+	std::sort(found.begin(), found.end());
+	found.erase(std::unique(found.begin(), found.end()), found.end());
+}
+
+bool brickgrid::cellRange( const SimRect &rect, int &col0, int &row0, int &col1, int &row1 ) const
+{
+	if(mCols == 0 || mRows == 0)
+	{
+		return false;
+	}
+
+	//Offsets are shifted to be non-negative before dividing so cells round down
+	int left = rect.x - mOriginX, top = rect.y - mOriginY;
+	int right = left + rect.w, bottom = top + rect.h;
+	if(right <= 0 || bottom <= 0)
+	{
+		return false;
+	}
+
+	col0 = std::max(left, 0) / brick::brick_width;
+	row0 = std::max(top, 0) / brick::brick_height;
+	//Right and bottom are one past the last pixel, a brick ending on a cell edge stays out of the next cell
+	col1 = std::min((right - 1) / brick::brick_width, mCols - 1);
+	row1 = std::min((bottom - 1) / brick::brick_height, mRows - 1);
+
+	return col0 <= col1 && row0 <= row1;
+}
+
+brickgame::brickgame()
+{
+	tickRate = referenceTickRate;
+	ballSpeed = ball::ball_VEL;
+	seed = 1;
+	level = NULL;
+	reset();
+}
+
+void brickgame::reset()
+{
+	mainPaddle = paddle();
+	mainBall = ball();
+
+	//A level lays the field out from data, with the same random types the built in field would get
+	if(level != NULL)
+	{
+		level->apply(gameBricks, grid, seed);
+	}
+	else
+	{
+		layoutBuiltIn();
+	}
+
+	mainBall.place(SCREEN_WIDTH/2 - ball::ball_WIDTH/2, SCREEN_HEIGHT - SCOREBOARD_HEIGHT - paddle::paddle_height - ball::ball_HEIGHT/2);
+
+	gamescore = 0;
+	gameOn = false;
+	bricksDestroyed = 0;
+	paddleHit = false;
+	destroyed.clear();
+}
+
+void brickgame::layoutBuiltIn()
+{
+	//Create the playing field with numGameBricks, arrange them and make them random types.
+	//The types come from an LCG started at seed, so a recorded game can be laid out again exactly.
+	gameBricks.clear();
+	unsigned int random = seed;
+
+	for(int i = 0; i < numGameBricks; i++)
+	{
+		brick b;
+		random = random * 1664525u + 1013904223u;
+		b.bricktype = (random >> 8) % numBrickTypes;
+
+		if(i < 9)
+		{
+			b.arrange(80*i+40, 20);
+		}
+		else if (i >= 9 && i < 18)
+		{
+			b.arrange(80*(i-9)+40, 40);
+		}
+		else if (i >= 18 && i < 27)
+		{
+			b.arrange(80*(i-18)+40, 60);
+		}
+		else
+		{
+			b.arrange(80*(i-27)+40, 80);
+		}
+
+		gameBricks.add(b);
+	}
+
+	grid.build(gameBricks);
+}
+
+void brickgame::handleInput( gameinput input, bool pressed )
+{
+	//Handle input for the paddle
+	mainPaddle.handleInput( input, pressed );
+
+	//Handle input for the ball
+	mainBall.handleInput( input, pressed, gameOn, ballSpeed );
+
+	// Once the user launches the ball, set gameOn to prevent any further launches changing velocity.
+	if( pressed && input == INPUT_LAUNCH )
+	{
+		gameOn = true;
+	}
+}
+
+void brickgame::step()
+{
+	moveObjects();
+	removeHit();
+}
+
+void brickgame::moveObjects()
+{
+	//Move the paddle
+	mainPaddle.move(tickRate);
+	paddleHit = mainBall.move(gameBricks, grid, mainPaddle, tickRate);
+}
+
+void brickgame::removeHit()
+{
+	bricksDestroyed = 0;
+	destroyed.clear();
+
+	//Remove destroyed blocks if they exist. Each removal is constant time, the last brick fills the hole.
+	for(int h = 0; h < mainBall.mBricksHit.size(); h++)
+	{
+		brickhandle handle = mainBall.mBricksHit[h];
+		int i = gameBricks.indexOf(handle);
+		if(i < 0)
+		{
+			continue;
+		}
+
+		gameBricks.hit[i] = true;
+		gameBricks.sides[i] = mainBall.mSidesHit[h];
+
+		//A brick with hit points to spare only loses one
+		if(gameBricks.hitPoints[i] > 1)
+		{
+			gameBricks.hitPoints[i]--;
+			continue;
+		}
+
+		brickdestroyed gone = { handle, gameBricks.get(i) };
+		destroyed.push_back(gone);
+
+		grid.remove(handle.slot, gameBricks.rect(i));
+		gameBricks.removeAt(i);
+
+		gamescore++;
+		bricksDestroyed++;
+	}
+}
+
+bool brickgame::cleared() const
+{
+	return gameBricks.empty();
+}
+
+unsigned long long brickgame::stateHash() const
+{
+	unsigned long long hash = hashBasis;
+	hash = hashValue(hash, mainPaddle.mPosX);
+	hash = hashValue(hash, mainPaddle.mVelX);
+	hash = hashValue(hash, mainBall.mPosX);
+	hash = hashValue(hash, mainBall.mPosY);
+	hash = hashValue(hash, mainBall.getVelX());
+	hash = hashValue(hash, mainBall.getVelY());
+	for(int i = 0; i < gameBricks.size(); i++)
+	{
+		hash = hashValue(hash, gameBricks.xs()[i]);
+		hash = hashValue(hash, gameBricks.ys()[i]);
+		hash = hashValue(hash, gameBricks.types[i]);
+		hash = hashValue(hash, gameBricks.hitPoints[i]);
+	}
+	hash = hashValue(hash, gamescore);
+	hash = hashValue(hash, gameOn);
+
+	return hash;
+}
+
+fixedstep::fixedstep( int tickRate, int maxSteps )
+{
+	mAccumulator = 0;
+	mTickRate = tickRate;
+	mTickSeconds = 1.0 / tickRate;
+	mMaxSteps = maxSteps;
+}
+
+int fixedstep::advance( double seconds )
+{
+	mAccumulator += seconds;
+
+	int steps = (int)( mAccumulator / mTickSeconds );
+	mAccumulator -= steps * mTickSeconds;
+
+	//A long stall would otherwise make us spiral, simulating ever more ticks per frame.
+	//Run the cap and drop the rest of the backlog.
+	if( steps > mMaxSteps )
+	{
+		steps = mMaxSteps;
+	}
+
+	return steps;
+}
+
+double fixedstep::alpha() const
+{
+	return mAccumulator / mTickSeconds;
+}
+
+int fixedstep::tickRate() const
+{
+	return mTickRate;
+}
+
+int stepDistance( int vel, int tickRate, int& remainder )
+{
+	int total = vel * referenceTickRate + remainder;
+	remainder = total % tickRate;
+	return total / tickRate;
+}
+
+bool checkCollision( Circle& a, SimRect& b)
+{
+    //Closest point on collision box
+    int cX, cY = 0;
+
+    //Find closest x offset
+    if( a.x < b.x )
+    {
+        cX = b.x;
+    }
+    else if( a.x > b.x + b.w )
+    {
+        cX = b.x + b.w;
+    }
+    else
+    {
+        cX = a.x;
+    }
+
+    //Find closest y offset
+    if( a.y < b.y )
+    {
+        cY = b.y;
+    }
+    else if( a.y > b.y + b.h )
+    {
+        cY = b.y + b.h;
+    }
+    else
+    {
+        cY = a.y;
+    }
+
+    //If the closest point is inside the circle
+    if( distanceSquared( a.x, a.y, cX, cY ) < a.r * a.r )
+    {
+        //This box and the circle have collided
+        return true;
+    }
+
+    //If the shapes have not collided
+    return false;
+}
+
+// Sets sidehit to the side of rect the circle hit. Return of true is success, return of false is that no side was hit
+bool updateCollisionSide(Circle& a, const SimRect& rect, brickside& sidehit)
+{
+	if(a.x < rect.x) // ball is to the left of the brick
+	{
+		if(a.y < rect.y - rect.h/2) // ball is above the brick
+		{
+			//This is a top hit
+			sidehit = TOP; return true;
+		}
+		else if (a.y > rect.y + rect.h/2) // ball is below the brick
+		{
+			//This is a bottom hit
+			sidehit = BOTTOM; return true;
+		}
+
+		else
+		{
+			//Ball is neither below or above the brick. This is a left hit
+			sidehit = LEFT; return true;
+		}
+	}
+
+	if(a.x > rect.x) // ball is to the right of the brick
+	{
+		if(a.y < rect.y - rect.h/2) // ball is above the brick
+		{
+			//This is a top hit
+			sidehit = TOP; return true;
+		}
+		else if (a.y > rect.y + rect.h/2) // ball is below the brick
+		{
+			//This is a bottom hit
+			sidehit = BOTTOM; return true;
+		}
+
+		else
+		{
+			//Ball is neither below or above the brick. This is a left hit
+			sidehit = RIGHT; return true;
+		}
+	}
+
+	return false;
+}
+
+//Bricks per batch kernel call when culling, and most distinct runs one ball looks at
+const int cullRunLength = 32;
+const int maxCullRuns = 8;
+
+//Drops the bricks in nearby that bound doesn't overlap, keeping the rest in order. The batch
+//kernel tests each run of cullRunLength bricks the slots fall in once, and a slot in a run past
+//the first maxCullRuns is kept untested.
+static void cullNearby( const Circle &bound, const brickfield &gameBricks, std::vector<unsigned int> &nearby )
+{
+	int bases[maxCullRuns];
+	unsigned int masks[maxCullRuns];
+	int numRuns = 0;
+
+	int kept = 0;
+	for(int n = 0; n < nearby.size(); n++)
+	{
+		int i = gameBricks.indexOfSlot(nearby[n]);
+		int base = i & ~(cullRunLength - 1);
+
+		int run = 0;
+		while(run < numRuns && bases[run] != base)
+		{
+			run++;
+		}
+		if(run == maxCullRuns)
+		{
+			nearby[kept++] = nearby[n];
+			continue;
+		}
+		if(run == numRuns)
+		{
+			int count = gameBricks.size() - base < cullRunLength ? gameBricks.size() - base : cullRunLength;
+			checkCollisionBatch(&bound, 1, gameBricks, base, count, &masks[run]);
+			bases[run] = base;
+			numRuns++;
+		}
+
+		if(masks[run] & (1u << (i - base)))
+		{
+			nearby[kept++] = nearby[n];
+		}
+	}
+	nearby.resize(kept);
+}
+
+bool sweepBall( ballstate &s, const brickfield &gameBricks, const brickgrid &grid, const SimRect *paddleBox, int paddleVelX, int tickRate, std::vector<unsigned int> &nearby, brickhandle *bricksHit, brickside *sidesHit, int &numHit )
+{
+	//Distance covered this tick. Bounces fold it back, so the ball never strays further than this on either axis.
+	double stepX = stepDistance( s.velX, tickRate, s.remX );
+	double stepY = stepDistance( s.velY, tickRate, s.remY );
+	double r = s.r;
+
+	//Only the bricks in the grid cells the ball can reach this tick can be touched
+	SimRect reach;
+	reach.x = s.x - s.r - (int)fabs(stepX);
+	reach.y = s.y - s.r - (int)fabs(stepY);
+	reach.w = 2*(s.r + (int)fabs(stepX));
+	reach.h = 2*(s.r + (int)fabs(stepY));
+
+	numHit = 0;
+	grid.query(reach, nearby);
+
+	//The box's corners are out of reach too. Bounces only fold the path back, so a circle
+	//around the start one step longer than the ball's radius holds every point it can touch.
+	if(nearby.size() > 1)
+	{
+		Circle bound = { s.x, s.y, s.r + (int)ceil(sqrt(stepX*stepX + stepY*stepY)) + 1 };
+		cullNearby(bound, gameBricks, nearby);
+	}
+
+	bool hitPaddle = false;
+	double x = s.x;
+	double y = s.y;
+
+	//Resolve contacts in the order they happen along the path
+	for(int contact = 0; contact < ballMaxContacts && (stepX != 0 || stepY != 0); contact++)
+	{
+		double first = 2;
+		bool flipX = false;
+		int brickHit = -1;
+		bool paddleHit = false;
+
+		//Screen edges, the ball bounces once its edge reaches one
+		if( stepX < 0 && x + stepX < r )
+		{
+			first = x > r ? (r - x) / stepX : 0;
+			flipX = true;
+		}
+		else if( stepX > 0 && x + stepX > SCREEN_WIDTH - r )
+		{
+			first = x < SCREEN_WIDTH - r ? (SCREEN_WIDTH - r - x) / stepX : 0;
+			flipX = true;
+		}
+
+		double toi;
+		brickside side;
+		if( stepY < 0 && y + stepY < r )
+		{
+			toi = y > r ? (r - y) / stepY : 0;
+			if( toi < first )
+			{
+				first = toi;
+				flipX = false;
+			}
+		}
+		else if( stepY > 0 && y + stepY > SCREEN_HEIGHT - r )
+		{
+			toi = y < SCREEN_HEIGHT - r ? (SCREEN_HEIGHT - r - y) / stepY : 0;
+			if( toi < first )
+			{
+				first = toi;
+				flipX = false;
+			}
+		}
+
+		//Bricks not already hit this tick
+		brickside brickSide = NONE;
+		for(int n = 0; n < nearby.size(); n++)
+		{
+			bool already = false;
+			for(int h = 0; h < numHit; h++)
+			{
+				already = already || bricksHit[h].slot == nearby[n];
+			}
+			if( already )
+			{
+				continue;
+			}
+
+			int c = gameBricks.indexOfSlot(nearby[n]);
+			if( sweepCircleRect( x, y, r, stepX, stepY, gameBricks.rect(c), toi, side ) && toi < first )
+			{
+				first = toi;
+				flipX = side == LEFT || side == RIGHT;
+				brickHit = c;
+				brickSide = side;
+			}
+		}
+
+		//The paddle, already moved this tick
+		if( paddleBox != NULL && sweepCircleRect( x, y, r, stepX, stepY, *paddleBox, toi, side ) && toi < first )
+		{
+			first = toi;
+			flipX = side == LEFT || side == RIGHT;
+			brickHit = -1;
+			paddleHit = true;
+		}
+
+		if( first > 1 )
+		{
+			break;
+		}
+
+		//Move up to the contact, what is left of the step bounces off it
+		x += stepX * first;
+		y += stepY * first;
+		stepX *= 1 - first;
+		stepY *= 1 - first;
+
+		//Bounce: the velocity, what is left of the step and the sub-pixel carry all turn round
+		if( flipX )
+		{
+			stepX = -stepX;
+			s.velX = s.velX*-1;
+			s.remX = -s.remX;
+		}
+		else
+		{
+			stepY = -stepY;
+			s.velY = -1*s.velY;
+			s.remY = -s.remY;
+		}
+
+		if( brickHit >= 0 )
+		{
+			//collision with a brick, note the brick and the side it was hit on
+			bricksHit[numHit] = gameBricks.handleAt(brickHit);
+			sidesHit[numHit] = brickSide;
+			numHit++;
+		}
+
+		if( paddleHit )
+		{
+			//change ball velocity based on paddles velocity
+			s.velX = s.velX + paddleVelX/4;
+			hitPaddle = true;
+		}
+
+		//Out of contacts, stop at the last one rather than move on unchecked
+		if( contact == ballMaxContacts - 1 )
+		{
+			stepX = 0;
+			stepY = 0;
+		}
+	}
+
+	s.x = (int)floor( x + stepX + 0.5 );
+	s.y = (int)floor( y + stepY + 0.5 );
+
+	return hitPaddle;
+}
+
+bool sweepCircleRect( double x, double y, double r, double dx, double dy, const SimRect& rect, double& toi, brickside& side )
+{
+	double left = rect.x;
+	double right = rect.x + rect.w;
+	double top = rect.y;
+	double bottom = rect.y + rect.h;
+
+	//Already touching: it's a contact now if the ball is heading further in
+	double cX = std::min(std::max(x, left), right);
+	double cY = std::min(std::max(y, top), bottom);
+	double nX = x - cX;
+	double nY = y - cY;
+	if( nX*nX + nY*nY < r*r )
+	{
+		if( nX == 0 && nY == 0 )
+		{
+			//Centre inside the rect, push out through the nearest face
+			double exits[4] = { x - left, right - x, y - top, bottom - y };
+			int nearest = (int)( std::min_element(exits, exits + 4) - exits );
+			nX = nearest == 0 ? -1 : nearest == 1 ? 1 : 0;
+			nY = nearest == 2 ? -1 : nearest == 3 ? 1 : 0;
+		}
+
+		if( nX*dx + nY*dy >= 0 )
+		{
+			return false;
+		}
+
+		toi = 0;
+		side = fabs(nX) > fabs(nY) ? ( nX < 0 ? LEFT : RIGHT ) : ( nY < 0 ? TOP : BOTTOM );
+		return true;
+	}
+
+	//The centre's path against the rect grown by r on every side, one slab per axis
+	double enter = 0;
+	double leave = 1;
+	bool enterX = false;
+
+	if( dx == 0 )
+	{
+		if( x <= left - r || x >= right + r )
+		{
+			return false;
+		}
+	}
+	else
+	{
+		double t0 = ( ( dx > 0 ? left - r : right + r ) - x ) / dx;
+		double t1 = ( ( dx > 0 ? right + r : left - r ) - x ) / dx;
+		if( t0 > enter )
+		{
+			enter = t0;
+			enterX = true;
+		}
+		leave = std::min(leave, t1);
+	}
+
+	if( dy == 0 )
+	{
+		if( y <= top - r || y >= bottom + r )
+		{
+			return false;
+		}
+	}
+	else
+	{
+		double t0 = ( ( dy > 0 ? top - r : bottom + r ) - y ) / dy;
+		double t1 = ( ( dy > 0 ? bottom + r : top - r ) - y ) / dy;
+		if( t0 > enter )
+		{
+			enter = t0;
+			enterX = false;
+		}
+		leave = std::min(leave, t1);
+	}
+
+	//Just touching and moving apart leaves as soon as it enters
+	if( enter >= leave )
+	{
+		return false;
+	}
+
+	//Entering beside a face is a face hit
+	double hitX = x + dx * enter;
+	double hitY = y + dy * enter;
+	if( ( hitX >= left && hitX <= right ) || ( hitY >= top && hitY <= bottom ) )
+	{
+		toi = enter;
+		if( enterX )
+		{
+			side = dx > 0 ? LEFT : RIGHT;
+		}
+		else
+		{
+			side = dy > 0 ? TOP : BOTTOM;
+		}
+		return true;
+	}
+
+	//Otherwise it came in by a corner, where the grown rect is rounded: hit the circle of radius r round the corner
+	double cornerX = hitX < left ? left : right;
+	double cornerY = hitY < top ? top : bottom;
+	double fX = x - cornerX;
+	double fY = y - cornerY;
+	double a = dx*dx + dy*dy;
+	double b = fX*dx + fY*dy;
+	double c = fX*fX + fY*fY - r*r;
+	double discriminant = b*b - a*c;
+	if( discriminant < 0 )
+	{
+		return false;
+	}
+
+	double t = ( -b - sqrt(discriminant) ) / a;
+	if( t < 0 || t > 1 )
+	{
+		return false;
+	}
+
+	toi = t;
+	nX = fX + dx * t;
+	nY = fY + dy * t;
+	side = fabs(nX) > fabs(nY) ? ( nX < 0 ? LEFT : RIGHT ) : ( nY < 0 ? TOP : BOTTOM );
+	return true;
+}
+
+int distanceSquared( int x1, int y1, int x2, int y2 )
+{
+	int deltaX = x2 - x1;
+	int deltaY = y2 - y1;
+	return deltaX*deltaX + deltaY*deltaY;
+}
+
+unsigned long long hashValue( unsigned long long hash, long long value )
+{
+	for(int byte = 0; byte < 8; byte++)
+	{
+		hash = (hash ^ ((value >> (byte * 8)) & 0xFF)) * 1099511628211ULL;
+	}
+	return hash;
+}
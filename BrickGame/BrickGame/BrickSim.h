@@ -0,0 +1,513 @@
+/*BrickGame simulation core. Everything in here is plain C++ with no SDL
+dependency so the game rules can be stepped headless, without a window,
+renderer or audio device.*/
+
+#pragma once
+
+#include <vector>
+
+//Screen dimension constants
+const int SCREEN_WIDTH = 800;
+const int SCREEN_HEIGHT = 800;
+
+//Score Board dimension
+const int SCOREBOARD_WIDTH = 800;
+const int SCOREBOARD_HEIGHT = 200;
+
+// Game globals
+const int numBrickTypes = 6;
+const int numPaddleTypes = 6;
+const int numBallTypes = 2;
+const int numGameBricks = 36;
+
+//Paddle and ball velocities are in pixels per tick at this rate
+const int referenceTickRate = 60;
+
+
+//Brick sides enum
+enum brickside
+{
+	NONE, TOP, RIGHT, BOTTOM, LEFT
+};
+
+//Player inputs the simulation understands
+enum gameinput
+{
+	INPUT_LEFT, INPUT_RIGHT, INPUT_LAUNCH
+};
+
+//Steps a tick is split into for inputs that land part way through it
+const int paddleSubsteps = 1024;
+
+//Most timed inputs one paddle holds for a tick
+const int paddleMaxTimed = 32;
+
+//A change to the paddle's control part way through a tick: a press or release of
+//left or right, an analog stick position from -1 to 1, or a relative nudge in pixels
+enum paddlecontrol
+{
+	PADDLE_PRESS, PADDLE_RELEASE, PADDLE_AXIS, PADDLE_NUDGE
+};
+
+struct timedpaddleinput
+{
+	//How far into the tick it happened, 0 at the start to paddleSubsteps at the end
+	int at;
+	paddlecontrol control;
+	gameinput input;
+	float value;
+};
+
+//A circle stucture
+struct Circle
+{
+	int x, y;
+	int r;
+};
+
+//An axis aligned box, same layout as SDL_Rect
+struct SimRect
+{
+	int x, y;
+	int w, h;
+};
+
+class paddle
+{
+    public:
+		//paddle dimensions
+		static const int paddle_width = 200;
+		static const int paddle_height = 24;
+
+		//Maximum axis velocity of the paddle
+		static const int paddle_vel = 8;
+
+		//Initializes the variables
+		paddle();
+
+		//Takes left/right presses and releases and adjusts the paddles velocity
+		void handleInput( gameinput input, bool pressed );
+
+		//Holds the paddle's direction for the moves that follow, -1 left, 1 right and 0 still,
+		//for controllers that pick a direction each tick rather than pressing keys
+		void steer( int direction );
+
+		//Queues a control change for the next move to apply part way through the tick.
+		//Inputs must be queued in time order. Returns false, applying it at once, when the queue is full,
+		//so a nudge that doesn't fit still moves the paddle.
+		bool queueTimed( const timedpaddleinput& input );
+
+		//Moves the paddle by one tick at the given tick rate. With timed inputs queued the
+		//velocity changes at each one's time within the tick, instead of for the whole tick.
+		void move( int tickRate = referenceTickRate );
+
+		SimRect mPaddleCollider;
+
+		//The velocity of the paddle
+		int mVelX, mVelY;
+
+		//The X and Y offsets
+		int mPosX, mPosY;
+
+    private:
+		//Sub-pixel motion left over from previous ticks
+		int mRemX;
+
+		//Velocity from an analog stick, in 256ths of a pixel per reference tick
+		int mAxisVel;
+
+		//Control changes for the next move
+		timedpaddleinput mTimed[paddleMaxTimed];
+		int mNumTimed;
+
+		//Applies one control change now
+		void applyControl( const timedpaddleinput& input );
+
+		//The move with timed inputs or a stick, integrating the velocity piece by piece
+		void moveTimed( int tickRate );
+
+		void shiftColliders();
+};
+
+class brick
+{
+    public:
+		//Brick dimensions
+		static const int brick_width = 80;
+		static const int brick_height = 20;
+		bool hitbyball;
+		brickside sidehit;
+		int bricktype;
+
+		//Hits it takes to destroy
+		int hitpoints;
+
+		SimRect brickRect;
+
+		//Initializes the variables
+		brick();
+
+		//Arrange brick in correct position
+		void arrange(int posX, int posY);
+};
+
+//Names one brick for as long as it lives. Handles stay valid while other bricks
+//come and go. Once the brick is removed its handle goes stale and stays stale,
+//even after the slot is reused, because the slot's generation moves on.
+struct brickhandle
+{
+	unsigned int slot;
+	unsigned int generation;
+};
+
+//Brick storage split by use. The x/y/w/h arrays every collision test reads are
+//packed on their own, 32 byte aligned and padded to a whole batch so the batch
+//kernel can load them straight into SIMD registers. Type, hit flag and side live apart.
+//Bricks are packed densely in index order 0 to size() - 1, so loops only ever touch
+//live bricks. Removing a brick moves the last one into its index in constant time.
+//Indices change when that happens, handles do not.
+class brickfield
+{
+public:
+	brickfield();
+	brickfield( const brickfield &other );
+	brickfield &operator=( const brickfield &other );
+	~brickfield();
+
+	//Removes every brick
+	void clear();
+
+	//Appends a brick and returns its handle
+	brickhandle add( const brick &b );
+
+	//Replaces the field with count bricks copied straight from the arrays, brick i getting
+	//slot i, so a grid saved alongside the arrays indexes them as they are
+	void assign( int count, const int *x, const int *y, const int *w, const int *h, const int *type, const int *hp );
+
+	//Moves every brick by dx, dy
+	void translate( int dx, int dy );
+
+	//Removes the brick, the last brick takes its index. Returns false for a stale handle.
+	bool remove( brickhandle h );
+
+	//Removes the brick at index i
+	void removeAt( int i );
+
+	//True while the handle's brick has not been removed
+	bool alive( brickhandle h ) const;
+
+	//Index of the handle's brick, -1 for a stale handle
+	int indexOf( brickhandle h ) const;
+
+	//Index of the live brick in a slot
+	int indexOfSlot( unsigned int slot ) const;
+
+	//Handle of the brick at index i
+	brickhandle handleAt( int i ) const;
+
+	int size() const;
+	bool empty() const;
+
+	//Brick i as a value, for drawing and inspection
+	brick get( int i ) const;
+	SimRect rect( int i ) const;
+
+	//Hot collision arrays, size() bricks followed by padding that never collides
+	const int *xs() const { return mX; }
+	const int *ys() const { return mY; }
+	const int *ws() const { return mW; }
+	const int *hs() const { return mH; }
+
+	//Cold per brick data
+	std::vector<int> types;
+	std::vector<int> hitPoints;
+	std::vector<bool> hit;
+	std::vector<brickside> sides;
+
+private:
+	//Hands out a free slot to the brick at index i
+	brickhandle claimSlot( int i );
+
+	//Makes room for at least capacity bricks, keeping what is stored
+	void reserve( int capacity );
+
+	//Parks entry i far away from everything with no size
+	void pad( int i );
+
+	//One aligned block holding the four hot arrays back to back
+	int *mBlock;
+	int *mX, *mY, *mW, *mH;
+	int mSize;
+	int mCapacity;
+
+	//Slot of the brick at each index
+	std::vector<unsigned int> mIndexSlot;
+
+	//Per slot: index of its brick and current generation
+	std::vector<int> mSlotIndex;
+	std::vector<unsigned int> mSlotGeneration;
+
+	//One bit per slot, set while the slot holds a brick
+	std::vector<unsigned long long> mLive;
+
+	//Slots waiting to be reused
+	std::vector<unsigned int> mFreeSlots;
+};
+
+//Bricks one batch kernel call tests
+const int brickBatchWidth = 8;
+
+//Tests every circle against bricks first to first + count - 1 of the field. first must be
+//a multiple of brickBatchWidth and count at most 32. Bit i of masks[c] is set when circle c overlaps brick first + i.
+//Uses AVX2 or SSE2 when the compiler targets them, else the scalar version. sweepBall uses it to
+//cull the grid's candidates before sweeping them.
+void checkCollisionBatch( const Circle *circles, int numCircles, const brickfield &field, int first, int count, unsigned int *masks );
+
+//Plain C++ version of checkCollisionBatch, gives the same masks
+void checkCollisionBatchScalar( const Circle *circles, int numCircles, const brickfield &field, int first, int count, unsigned int *masks );
+
+//Which instruction set checkCollisionBatch was built with
+const char *collisionBatchPath();
+
+//Uniform grid over the brick field with one brick sized cell per entry, so the
+//ball only looks at the bricks in the few cells it overlaps.
+//Cells hold the handle slots of the bricks, which do not change as the field is compacted.
+//Bricks are only ever removed between builds, so the cells are packed back to back in
+//one array, each keeping its live slots at the front of the range it started with.
+class brickgrid
+{
+public:
+	brickgrid();
+
+	//Indexes every brick in the field, replacing what was there
+	void build( const brickfield &gameBricks );
+
+	//Takes a grid built earlier: cellStart holds cols * rows + 1 offsets into slots
+	void assign( int originX, int originY, int cols, int rows, const unsigned int *cellStart, const unsigned int *slots );
+
+	//Follows a field moved by brickfield::translate, in constant time
+	void translate( int dx, int dy );
+
+	//The grid as assign takes it, with bricks removed since the build left out
+	void save( int &originX, int &originY, int &cols, int &rows, std::vector<unsigned int> &cellStart, std::vector<unsigned int> &slots ) const;
+
+	//Drops the brick in slot from the cells its rect covers
+	void remove( unsigned int slot, const SimRect &rect );
+
+	//Slots of bricks in the cells overlapping area, in ascending order with no repeats.
+	//The result is reused by the next query.
+	const std::vector<unsigned int> &query( const SimRect &area );
+
+	//The same into the caller's vector, safe to call from several threads at once
+	void query( const SimRect &area, std::vector<unsigned int> &found ) const;
+
+private:
+	//Cell range covered by a rect, clamped to the grid. Returns false if it misses the grid.
+	bool cellRange( const SimRect &rect, int &col0, int &row0, int &col1, int &row1 ) const;
+
+	//Top left of cell 0,0 and grid size in cells
+	int mOriginX, mOriginY;
+	int mCols, mRows;
+
+	//Cell c's slots are mSlots[mCellStart[c]] onwards, mCellCount[c] of them
+	std::vector<unsigned int> mCellStart;
+	std::vector<unsigned int> mCellCount;
+	std::vector<unsigned int> mSlots;
+
+	//Scratch space for query results
+	std::vector<unsigned int> mFound;
+};
+
+//Most contacts one ball move resolves
+const int ballMaxContacts = 4;
+
+//Everything a ball move reads and changes, velocities in pixels per reference tick
+struct ballstate
+{
+	int x, y;
+	int velX, velY;
+	int remX, remY;
+	int r;
+};
+
+class ball
+{
+    public:
+		//The dimensions of the ball
+		static const int ball_WIDTH = 20;
+		static const int ball_HEIGHT = 20;
+
+		//Maximum axis velocity of the ball
+		static const int ball_VEL = 6;
+
+		//Initializes the variables
+		ball();
+
+		//Most contacts resolved in one move, a ball wedged in a corner stops at the last one
+		static const int max_contacts = ballMaxContacts;
+
+		//Takes the launch press and adjusts the ball, speed is the launch velocity on each axis
+		void handleInput( gameinput input, bool pressed, bool gameOn, int speed = ball_VEL );
+
+		//Moves the ball by one tick at the given tick rate, returns true if it bounced off the paddle.
+		//The ball is swept along its path, so it can't pass through a brick however far it moves in a tick.
+		//Bricks and paddle are only read, the bricks hit are left in mBricksHit for the caller to remove,
+		//so many balls can move at once against the same field.
+		bool move(const brickfield &gameBricks, const brickgrid &grid, const paddle &gamePaddle, int tickRate = referenceTickRate);
+
+		//Places the ball at the given offsets
+		void place(int posX, int posY);
+
+		//Sets the ball moving, in pixels per reference tick
+		void launch(int velX, int velY);
+
+		//Velocity in pixels per reference tick
+		int getVelX() const;
+		int getVelY() const;
+
+		// ball collision circle
+		Circle mBallCollider;
+
+		//The X and Y offsets of the ball
+		int mPosX, mPosY;
+
+		//The bricks hit during the last move and the side each was hit on
+		std::vector<brickhandle> mBricksHit;
+		std::vector<brickside> mSidesHit;
+
+    private:
+		//The velocity of the ball
+		int mVelX, mVelY;
+
+		//Sub-pixel motion left over from previous ticks
+		int mRemX, mRemY;
+
+		//Scratch space for grid queries
+		std::vector<unsigned int> mNearby;
+
+		////Moves the collision circle relative to the balls offset
+		void shiftColliders();
+};
+
+//A brick destroyed during the last step. The handle is already stale, the brick
+//is a copy of its last state for score, sound and effects.
+struct brickdestroyed
+{
+	brickhandle handle;
+	brick b;
+};
+
+class bricklevel;
+
+//The complete state of one game: paddle, ball, bricks and score
+class brickgame
+{
+public:
+	brickgame();
+
+	//Lays out a fresh brick field, from level if one is set, and puts paddle and ball at the start
+	void reset();
+
+	//Feeds a press or release to the paddle and ball
+	void handleInput( gameinput input, bool pressed );
+
+	//Advances the game by one tick, moving then removing
+	void step();
+
+	//The two halves of a tick: move the paddle and ball, then remove the bricks the ball hit
+	void moveObjects();
+	void removeHit();
+
+	//True once every brick has been cleared
+	bool cleared() const;
+
+	//Hash of the paddle, ball, bricks and score, equal for equal states
+	unsigned long long stateHash() const;
+
+	//Picks the brick types reset lays out, the same seed always gives the same field
+	unsigned int seed;
+
+	//Level reset lays out, NULL for the built in field of numGameBricks bricks. Not owned.
+	const bricklevel* level;
+
+	//Ticks per second of simulated time, speeds stay the same at any rate
+	int tickRate;
+
+	paddle mainPaddle;
+	ball mainBall;
+	brickfield gameBricks;
+
+	//Broadphase over gameBricks, rebuild it after changing the bricks by hand
+	brickgrid grid;
+
+	// number of bricks cleared
+	int gamescore;
+
+	// Game has started?
+	bool gameOn;
+
+	//Launch velocity of the ball on each axis, in pixels per reference tick
+	int ballSpeed;
+
+	//What happened during the last step, so the caller can play sounds
+	int bricksDestroyed;
+	bool paddleHit;
+	std::vector<brickdestroyed> destroyed;
+
+private:
+	//The original 4 rows of 9 bricks
+	void layoutBuiltIn();
+};
+
+//Runs the simulation at a fixed rate no matter how fast frames are presented.
+//Feed it the real time each frame took and run the number of ticks it returns.
+class fixedstep
+{
+public:
+	fixedstep( int tickRate = 120, int maxSteps = 8 );
+
+	//Adds elapsed seconds and returns how many ticks are due, never more than maxSteps
+	int advance( double seconds );
+
+	//How far into the next tick the accumulator is, 0 to 1, for interpolated rendering
+	double alpha() const;
+
+	int tickRate() const;
+
+private:
+	double mAccumulator;
+	double mTickSeconds;
+	int mTickRate;
+	int mMaxSteps;
+};
+
+//Converts a velocity in pixels per reference tick into whole pixels for one tick
+//at tickRate, carrying the fraction over in remainder
+int stepDistance( int vel, int tickRate, int& remainder );
+
+//Circle/Box collision detector
+bool checkCollision( Circle& a, SimRect& b );
+
+// Works out which side of rect the circle hit
+bool updateCollisionSide(Circle& a, const SimRect& rect, brickside& sidehit);
+
+//One tick of ball movement, shared by ball::move and the entity systems. The circle is swept
+//against the screen edges, the bricks in the grid and the paddle's box, if there is one, moving at
+//paddleVelX, bouncing off up to ballMaxContacts of them in the order they are reached. The bricks
+//hit go in bricksHit and sidesHit, numHit of them. Returns true if it bounced off the paddle.
+//nearby is scratch space.
+bool sweepBall( ballstate &s, const brickfield &gameBricks, const brickgrid &grid, const SimRect *paddleBox, int paddleVelX, int tickRate, std::vector<unsigned int> &nearby, brickhandle *bricksHit, brickside *sidesHit, int &numHit );
+
+//Sweeps a circle of radius r from x, y by dx, dy against rect. Returns true if it touches rect while
+//moving towards it, with toi the fraction of the move done at first contact and side the face of rect
+//that was hit. A corner counts as whichever face the contact normal is nearer to.
+bool sweepCircleRect( double x, double y, double r, double dx, double dy, const SimRect& rect, double& toi, brickside& side );
+
+//FNV-1a starting value for hashValue
+const unsigned long long hashBasis = 14695981039346656037ULL;
+
+//Mixes the 8 bytes of value into an FNV-1a hash
+unsigned long long hashValue( unsigned long long hash, long long value );
+
+//Calculates distance squared between two points
+int distanceSquared( int x1, int y1, int x2, int y2 );
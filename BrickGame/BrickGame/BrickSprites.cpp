@@ -0,0 +1,284 @@
+/*Batched sprite drawing and the cached brick layer.*/
+
+#include "BrickSprites.h"
+#include <stdio.h>
+
+LSpriteBatch::LSpriteBatch()
+{
+	//Initialize
+	mSprites = 0;
+	mDrawCalls = 0;
+}
+
+LSpriteBatch::bucket* LSpriteBatch::bucketFor( SDL_Texture* texture )
+{
+	//Find this texture's bucket, there are only ever a handful
+	for( int i = 0; i < mBuckets.size(); i++ )
+	{
+		if( mBuckets[i].texture == texture )
+		{
+			return &mBuckets[i];
+		}
+	}
+
+	mBuckets.push_back( bucket() );
+	bucket* b = &mBuckets.back();
+	b->texture = texture;
+
+	#ifdef LSPRITEBATCH_GEOMETRY
+	//Texture coordinates are 0 to 1 across the texture
+	int w = 1, h = 1;
+	SDL_QueryTexture( texture, NULL, NULL, &w, &h );
+	b->invWidth = 1.0f / w;
+	b->invHeight = 1.0f / h;
+	#endif
+
+	return b;
+}
+
+void LSpriteBatch::add( SDL_Texture* texture, const SDL_Rect& clip, int x, int y )
+{
+	SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+	add( texture, clip, (float)x, (float)y, (float)clip.w, (float)clip.h, white );
+}
+
+void LSpriteBatch::add( SDL_Texture* texture, const SDL_Rect& clip, float x, float y, float w, float h, SDL_Color color )
+{
+	bucket* b = bucketFor( texture );
+
+	#ifdef LSPRITEBATCH_GEOMETRY
+	//Two triangles, corners in the order top left, top right, bottom right, bottom left
+	int first = b->vertices.size();
+	float left = x, top = y;
+	float right = x + w, bottom = y + h;
+	float u0 = clip.x * b->invWidth, v0 = clip.y * b->invHeight;
+	float u1 = ( clip.x + clip.w ) * b->invWidth, v1 = ( clip.y + clip.h ) * b->invHeight;
+
+	SDL_Vertex corners[4] =
+	{
+		{ { left, top }, color, { u0, v0 } },
+		{ { right, top }, color, { u1, v0 } },
+		{ { right, bottom }, color, { u1, v1 } },
+		{ { left, bottom }, color, { u0, v1 } }
+	};
+	b->vertices.insert( b->vertices.end(), corners, corners + 4 );
+
+	int quad[6] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+	b->indices.insert( b->indices.end(), quad, quad + 6 );
+	#else
+	SDL_Rect renderQuad = { (int)x, (int)y, (int)w, (int)h };
+	b->clips.push_back( clip );
+	b->quads.push_back( renderQuad );
+	b->colors.push_back( color );
+	#endif
+
+	mSprites++;
+}
+
+void LSpriteBatch::flush( SDL_Renderer* renderer )
+{
+	for( int i = 0; i < mBuckets.size(); i++ )
+	{
+		bucket& b = mBuckets[i];
+
+		#ifdef LSPRITEBATCH_GEOMETRY
+		if( !b.indices.empty() )
+		{
+			SDL_RenderGeometry( renderer, b.texture, &b.vertices[0], b.vertices.size(), &b.indices[0], b.indices.size() );
+			mDrawCalls++;
+		}
+
+		//Clear keeps the capacity for next frame
+		b.vertices.clear();
+		b.indices.clear();
+		#else
+		for( int q = 0; q < b.quads.size(); q++ )
+		{
+			//Tinted sprites set the texture's modulation just for themselves
+			SDL_Color c = b.colors[q];
+			bool tinted = c.r != 0xFF || c.g != 0xFF || c.b != 0xFF || c.a != 0xFF;
+			if( tinted )
+			{
+				SDL_SetTextureColorMod( b.texture, c.r, c.g, c.b );
+				SDL_SetTextureAlphaMod( b.texture, c.a );
+			}
+
+			SDL_RenderCopy( renderer, b.texture, &b.clips[q], &b.quads[q] );
+			mDrawCalls++;
+
+			if( tinted )
+			{
+				SDL_SetTextureColorMod( b.texture, 0xFF, 0xFF, 0xFF );
+				SDL_SetTextureAlphaMod( b.texture, 0xFF );
+			}
+		}
+
+		b.clips.clear();
+		b.quads.clear();
+		b.colors.clear();
+		#endif
+	}
+}
+
+int LSpriteBatch::getSprites()
+{
+	return mSprites;
+}
+
+int LSpriteBatch::getDrawCalls()
+{
+	return mDrawCalls;
+}
+
+int LSpriteBatch::getDrawCallsSaved()
+{
+	return mSprites - mDrawCalls;
+}
+
+void LSpriteBatch::resetStats()
+{
+	mSprites = 0;
+	mDrawCalls = 0;
+}
+
+LBrickLayer::LBrickLayer()
+{
+	//Initialize
+	mTexture = NULL;
+	mWidth = 0;
+	mHeight = 0;
+	mBricksDrawn = 0;
+}
+
+LBrickLayer::~LBrickLayer()
+{
+	//Deallocate
+	free();
+}
+
+bool LBrickLayer::create( SDL_Renderer* renderer, int w, int h )
+{
+	//Get rid of preexisting layer
+	free();
+
+	if( !SDL_RenderTargetSupported( renderer ) )
+	{
+		printf( "Renderer does not support target textures, brick layer unavailable!\n" );
+		return false;
+	}
+
+	mTexture = SDL_CreateTexture( renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, w, h );
+	if( mTexture == NULL )
+	{
+		printf( "Unable to create brick layer texture! SDL Error: %s\n", SDL_GetError() );
+		return false;
+	}
+
+	//Empty parts of the layer must let the background through
+	SDL_SetTextureBlendMode( mTexture, SDL_BLENDMODE_BLEND );
+	mWidth = w;
+	mHeight = h;
+
+	return true;
+}
+
+void LBrickLayer::free()
+{
+	//Free texture if it exists
+	if( mTexture != NULL )
+	{
+		SDL_DestroyTexture( mTexture );
+		mTexture = NULL;
+		mWidth = 0;
+		mHeight = 0;
+	}
+}
+
+void LBrickLayer::rebuild( SDL_Renderer* renderer, const brickfield& bricks, SDL_Texture* brickTexture, const SDL_Rect* brickClips )
+{
+	if( mTexture == NULL )
+	{
+		return;
+	}
+
+	SDL_Texture* previousTarget = SDL_GetRenderTarget( renderer );
+	SDL_SetRenderTarget( renderer, mTexture );
+
+	clearRect( renderer, NULL );
+	for( int i = 0; i < bricks.size(); i++ )
+	{
+		drawBrick( renderer, bricks, i, brickTexture, brickClips );
+	}
+
+	SDL_SetRenderTarget( renderer, previousTarget );
+}
+
+void LBrickLayer::erase( SDL_Renderer* renderer, const SimRect& rect, const brickfield& bricks, brickgrid& grid, SDL_Texture* brickTexture, const SDL_Rect* brickClips )
+{
+	if( mTexture == NULL )
+	{
+		return;
+	}
+
+	SDL_Texture* previousTarget = SDL_GetRenderTarget( renderer );
+	SDL_SetRenderTarget( renderer, mTexture );
+
+	SDL_Rect hole = { rect.x, rect.y, rect.w, rect.h };
+	clearRect( renderer, &hole );
+
+	//Bricks that shared any of those pixels get drawn again, the grid knows which they are
+	const std::vector<unsigned int>& nearby = grid.query( rect );
+	for( int n = 0; n < nearby.size(); n++ )
+	{
+		drawBrick( renderer, bricks, bricks.indexOfSlot( nearby[n] ), brickTexture, brickClips );
+	}
+
+	SDL_SetRenderTarget( renderer, previousTarget );
+}
+
+void LBrickLayer::render( SDL_Renderer* renderer, int x, int y )
+{
+	if( mTexture != NULL )
+	{
+		SDL_Rect renderQuad = { x, y, mWidth, mHeight };
+		SDL_RenderCopy( renderer, mTexture, NULL, &renderQuad );
+	}
+}
+
+int LBrickLayer::getBricksDrawn()
+{
+	return mBricksDrawn;
+}
+
+void LBrickLayer::resetStats()
+{
+	mBricksDrawn = 0;
+}
+
+void LBrickLayer::drawBrick( SDL_Renderer* renderer, const brickfield& bricks, int i, SDL_Texture* brickTexture, const SDL_Rect* brickClips )
+{
+	const SDL_Rect& clip = brickClips[bricks.types[i]];
+	SDL_Rect renderQuad = { bricks.xs()[i], bricks.ys()[i], clip.w, clip.h };
+	SDL_RenderCopy( renderer, brickTexture, &clip, &renderQuad );
+	mBricksDrawn++;
+}
+
+void LBrickLayer::clearRect( SDL_Renderer* renderer, const SDL_Rect* rect )
+{
+	//Write transparent pixels rather than blending them over what is there
+	Uint8 r, g, b, a;
+	SDL_GetRenderDrawColor( renderer, &r, &g, &b, &a );
+	SDL_SetRenderDrawBlendMode( renderer, SDL_BLENDMODE_NONE );
+	SDL_SetRenderDrawColor( renderer, 0, 0, 0, 0 );
+
+	if( rect == NULL )
+	{
+		SDL_RenderClear( renderer );
+	}
+	else
+	{
+		SDL_RenderFillRect( renderer, rect );
+	}
+
+	SDL_SetRenderDrawColor( renderer, r, g, b, a );
+}
@@ -0,0 +1,111 @@
+/*Batched sprite drawing. Sprites are collected as textured quads during the
+frame and submitted with one SDL_RenderGeometry call per texture, instead of
+one SDL_RenderCopy per sprite.
+
+LBrickLayer goes further for the brick field, which only changes when a brick
+is destroyed: it keeps the bricks drawn in a target texture and patches it.*/
+
+#pragma once
+
+#include <SDL.h>
+#include <vector>
+#include "BrickSim.h"
+
+//SDL_RenderGeometry arrived in SDL 2.0.18. Older SDL draws each queued sprite with SDL_RenderCopy.
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define LSPRITEBATCH_GEOMETRY
+#endif
+
+class LSpriteBatch
+{
+	public:
+		//Initializes variables
+		LSpriteBatch();
+
+		//Queues clip of texture to be drawn at x, y
+		void add( SDL_Texture* texture, const SDL_Rect& clip, int x, int y );
+
+		//Queues clip of texture stretched to w x h at x, y and tinted by color
+		void add( SDL_Texture* texture, const SDL_Rect& clip, float x, float y, float w, float h, SDL_Color color );
+
+		//Draws everything queued, one submission per texture in the order textures were first used
+		void flush( SDL_Renderer* renderer );
+
+		//Sprites queued and submissions made since the last resetStats
+		int getSprites();
+		int getDrawCalls();
+
+		//Draw calls batching saved over drawing every sprite on its own
+		int getDrawCallsSaved();
+
+		//Starts counting afresh, call once a frame
+		void resetStats();
+
+	private:
+		//Quads waiting for one texture
+		struct bucket
+		{
+			SDL_Texture* texture;
+			#ifdef LSPRITEBATCH_GEOMETRY
+			float invWidth, invHeight;
+			std::vector<SDL_Vertex> vertices;
+			std::vector<int> indices;
+			#else
+			std::vector<SDL_Rect> clips;
+			std::vector<SDL_Rect> quads;
+			std::vector<SDL_Color> colors;
+			#endif
+		};
+
+		//The bucket queuing texture, made on first use
+		bucket* bucketFor( SDL_Texture* texture );
+
+		//Buckets are kept between frames so their arrays are not reallocated
+		std::vector<bucket> mBuckets;
+
+		int mSprites;
+		int mDrawCalls;
+};
+
+//The brick field drawn once into a render target texture. Each frame it is
+//shown as a single quad, and a destroyed brick only costs clearing its rect.
+class LBrickLayer
+{
+	public:
+		//Initializes variables
+		LBrickLayer();
+
+		//Deallocates memory
+		~LBrickLayer();
+
+		//Creates a transparent w x h target texture, fails if the renderer has no target support
+		bool create( SDL_Renderer* renderer, int w, int h );
+
+		//Deallocates the layer
+		void free();
+
+		//Draws every brick from scratch, for a new field or after the renderer lost its targets
+		void rebuild( SDL_Renderer* renderer, const brickfield& bricks, SDL_Texture* brickTexture, const SDL_Rect* brickClips );
+
+		//Clears the rect of a brick that was just removed, then redraws any remaining bricks it overlapped
+		void erase( SDL_Renderer* renderer, const SimRect& rect, const brickfield& bricks, brickgrid& grid, SDL_Texture* brickTexture, const SDL_Rect* brickClips );
+
+		//Shows the layer with its top left corner at x, y
+		void render( SDL_Renderer* renderer, int x, int y );
+
+		//Bricks drawn into the layer since the last resetStats
+		int getBricksDrawn();
+		void resetStats();
+
+	private:
+		//Draws brick i of the field into the current target
+		void drawBrick( SDL_Renderer* renderer, const brickfield& bricks, int i, SDL_Texture* brickTexture, const SDL_Rect* brickClips );
+
+		//Clears rect of the layer to transparent, the layer must be the current target
+		void clearRect( SDL_Renderer* renderer, const SDL_Rect* rect );
+
+		SDL_Texture* mTexture;
+		int mWidth;
+		int mHeight;
+		int mBricksDrawn;
+};
@@ -0,0 +1,166 @@
+/*Work-stealing task pool for the simulation core.*/
+
+#include "BrickTasks.h"
+
+taskpool::taskpool( int threads )
+{
+	if( threads < 1 )
+	{
+		threads = 1;
+	}
+
+	mBody = NULL;
+	mGeneration = 0;
+	mFinished = 0;
+	mQuit = false;
+	mSteals = 0;
+
+	for( int i = 0; i < threads; i++ )
+	{
+		mQueues.push_back( std::unique_ptr<workqueue>( new workqueue ) );
+	}
+
+	//Queue 0 belongs to whoever calls parallelFor
+	for( int i = 1; i < threads; i++ )
+	{
+		mHelpers.push_back( std::thread( &taskpool::helperMain, this, i ) );
+	}
+}
+
+taskpool::~taskpool()
+{
+	{
+		std::lock_guard<std::mutex> guard( mLock );
+		mQuit = true;
+	}
+	mWake.notify_all();
+
+	for( int i = 0; i < mHelpers.size(); i++ )
+	{
+		mHelpers[i].join();
+	}
+}
+
+int taskpool::threads() const
+{
+	return mQueues.size();
+}
+
+void taskpool::parallelFor( int count, int grain, const std::function<void( int, int )> &body )
+{
+	if( count <= 0 )
+	{
+		return;
+	}
+	if( grain < 1 )
+	{
+		grain = 1;
+	}
+
+	//Nothing to share, skip the wake up
+	if( mHelpers.empty() || count <= grain )
+	{
+		body( 0, count );
+		return;
+	}
+
+	//Deal the chunks out round robin, neighbouring chunks land on different threads
+	for( int first = 0, q = 0; first < count; first += grain, q = ( q + 1 ) % mQueues.size() )
+	{
+		chunk c = { first, first + grain < count ? first + grain : count };
+		std::lock_guard<std::mutex> guard( mQueues[q]->lock );
+		mQueues[q]->chunks.push_back( c );
+	}
+
+	{
+		std::lock_guard<std::mutex> guard( mLock );
+		mBody = &body;
+		mFinished = 0;
+		mGeneration++;
+	}
+	mWake.notify_all();
+
+	work( 0 );
+
+	//body lives on the caller's stack, every helper must be done with it
+	std::unique_lock<std::mutex> lock( mLock );
+	while( mFinished < (int)mHelpers.size() )
+	{
+		mDone.wait( lock );
+	}
+	mBody = NULL;
+}
+
+long long taskpool::steals() const
+{
+	return mSteals.load();
+}
+
+bool taskpool::take( int self, chunk &c )
+{
+	{
+		workqueue &own = *mQueues[self];
+		std::lock_guard<std::mutex> guard( own.lock );
+		if( !own.chunks.empty() )
+		{
+			c = own.chunks.back();
+			own.chunks.pop_back();
+			return true;
+		}
+	}
+
+	//Own queue is dry, steal the oldest chunk of the next thread that has any
+	for( int i = 1; i < mQueues.size(); i++ )
+	{
+		workqueue &victim = *mQueues[( self + i ) % mQueues.size()];
+		std::lock_guard<std::mutex> guard( victim.lock );
+		if( !victim.chunks.empty() )
+		{
+			c = victim.chunks.front();
+			victim.chunks.pop_front();
+			mSteals++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void taskpool::work( int self )
+{
+	//No chunks are added while a parallelFor runs, so once every queue is empty it stays empty
+	chunk c;
+	while( take( self, c ) )
+	{
+		( *mBody )( c.first, c.last );
+	}
+}
+
+void taskpool::helperMain( int self )
+{
+	unsigned int seen = 0;
+
+	while( true )
+	{
+		{
+			std::unique_lock<std::mutex> lock( mLock );
+			while( !mQuit && mGeneration == seen )
+			{
+				mWake.wait( lock );
+			}
+			if( mQuit )
+			{
+				return;
+			}
+			seen = mGeneration;
+		}
+
+		work( self );
+
+		{
+			std::lock_guard<std::mutex> guard( mLock );
+			mFinished++;
+		}
+		mDone.notify_one();
+	}
+}
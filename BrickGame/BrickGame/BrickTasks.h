@@ -0,0 +1,74 @@
+/*Work-stealing task pool for the simulation core. Plain C++11 threads, no SDL.
+
+parallelFor cuts an index range into chunks and deals them out to one queue
+per thread. Each thread works through its own queue from the back, and once
+that is empty steals from the front of the others, so a thread that drew
+cheap chunks helps out the ones that drew expensive chunks.*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class taskpool
+{
+public:
+	//Runs work on threads threads in all, the thread calling parallelFor being one of them
+	explicit taskpool( int threads );
+
+	//Stops the helper threads
+	~taskpool();
+
+	int threads() const;
+
+	//Calls body(first, last) on chunks of at most grain indices covering [0, count),
+	//returns once every chunk has run. Chunks run in no particular order or thread.
+	void parallelFor( int count, int grain, const std::function<void( int, int )> &body );
+
+	//Chunks a thread took from another thread's queue since the pool was made
+	long long steals() const;
+
+private:
+	struct chunk
+	{
+		int first, last;
+	};
+
+	//One thread's queue, locked only while a chunk is pushed or taken
+	struct workqueue
+	{
+		std::mutex lock;
+		std::deque<chunk> chunks;
+	};
+
+	//Pops from the back of thread self's queue, or steals from the front of another
+	bool take( int self, chunk &c );
+
+	//Runs chunks until every queue is empty
+	void work( int self );
+
+	//Helper thread loop, waits for each parallelFor call and joins in
+	void helperMain( int self );
+
+	std::vector< std::unique_ptr<workqueue> > mQueues;
+	std::vector<std::thread> mHelpers;
+
+	//The body of the parallelFor in progress
+	const std::function<void( int, int )> *mBody;
+
+	//Helpers sleep until the generation changes, and report back when done with it
+	std::mutex mLock;
+	std::condition_variable mWake;
+	std::condition_variable mDone;
+	unsigned int mGeneration;
+	int mFinished;
+	bool mQuit;
+
+	std::atomic<long long> mSteals;
+};
@@ -0,0 +1,185 @@
+/*Cached text rendering through a glyph atlas.*/
+
+#include "BrickText.h"
+#include "BrickTrace.h"
+#include <stdio.h>
+
+LGlyphAtlas::LGlyphAtlas()
+{
+	//Initialize
+	mTexture = NULL;
+	mSurface = NULL;
+	mHeight = 0;
+
+	for( int g = 0; g <= lastAtlasGlyph - firstAtlasGlyph; g++ )
+	{
+		mGlyphs[g].x = 0;
+		mGlyphs[g].y = 0;
+		mGlyphs[g].w = 0;
+		mGlyphs[g].h = 0;
+	}
+}
+
+LGlyphAtlas::~LGlyphAtlas()
+{
+	//Deallocate
+	free();
+}
+
+bool LGlyphAtlas::build( SDL_Renderer* renderer, TTF_Font* font, SDL_Color color )
+{
+	return rasterize( font, color ) && upload( renderer );
+}
+
+bool LGlyphAtlas::rasterize( TTF_Font* font, SDL_Color color )
+{
+	//Get rid of preexisting atlas
+	free();
+
+	//Render each glyph on its own. Rendering it as a one character string gives a
+	//surface as wide as the glyph's advance, so glyphs can be laid end to end.
+	const int numGlyphs = lastAtlasGlyph - firstAtlasGlyph + 1;
+	SDL_Surface* glyphSurfaces[numGlyphs];
+	int atlasWidth = 0;
+	int atlasHeight = 0;
+
+	for( int g = 0; g < numGlyphs; g++ )
+	{
+		SDL_Rect empty = { 0, 0, 0, 0 };
+		mGlyphs[g] = empty;
+
+		char glyphText[2] = { (char)( firstAtlasGlyph + g ), '\0' };
+		glyphSurfaces[g] = TTF_RenderText_Solid( font, glyphText, color );
+		if( glyphSurfaces[g] == NULL )
+		{
+			//Leave the glyph empty, strings using it just skip it
+			printf( "Unable to render glyph %d! SDL_ttf Error: %s\n", firstAtlasGlyph + g, TTF_GetError() );
+			continue;
+		}
+
+		mGlyphs[g].x = atlasWidth;
+		mGlyphs[g].y = 0;
+		mGlyphs[g].w = glyphSurfaces[g]->w;
+		mGlyphs[g].h = glyphSurfaces[g]->h;
+
+		atlasWidth += glyphSurfaces[g]->w;
+		if( glyphSurfaces[g]->h > atlasHeight )
+		{
+			atlasHeight = glyphSurfaces[g]->h;
+		}
+	}
+
+	//Copy every glyph into one transparent surface
+	SDL_Surface* atlasSurface = NULL;
+	if( atlasWidth > 0 )
+	{
+		atlasSurface = SDL_CreateRGBSurface( 0, atlasWidth, atlasHeight, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 );
+		if( atlasSurface == NULL )
+		{
+			printf( "Unable to create glyph atlas surface! SDL Error: %s\n", SDL_GetError() );
+		}
+	}
+
+	for( int g = 0; g < numGlyphs; g++ )
+	{
+		if( glyphSurfaces[g] != NULL )
+		{
+			if( atlasSurface != NULL )
+			{
+				SDL_BlitSurface( glyphSurfaces[g], NULL, atlasSurface, &mGlyphs[g] );
+			}
+			SDL_FreeSurface( glyphSurfaces[g] );
+		}
+	}
+
+	mSurface = atlasSurface;
+	mHeight = atlasHeight;
+
+	return mSurface != NULL;
+}
+
+bool LGlyphAtlas::upload( SDL_Renderer* renderer )
+{
+	if( mSurface == NULL )
+	{
+		return false;
+	}
+
+	//Upload the atlas once
+	mTexture = SDL_CreateTextureFromSurface( renderer, mSurface );
+	if( mTexture == NULL )
+	{
+		printf( "Unable to create glyph atlas texture! SDL Error: %s\n", SDL_GetError() );
+	}
+	else
+	{
+		SDL_SetTextureBlendMode( mTexture, SDL_BLENDMODE_BLEND );
+	}
+
+	SDL_FreeSurface( mSurface );
+	mSurface = NULL;
+
+	return mTexture != NULL;
+}
+
+void LGlyphAtlas::free()
+{
+	//Free texture if it exists
+	if( mTexture != NULL )
+	{
+		SDL_DestroyTexture( mTexture );
+		mTexture = NULL;
+	}
+
+	//Free a surface that never got uploaded
+	if( mSurface != NULL )
+	{
+		SDL_FreeSurface( mSurface );
+		mSurface = NULL;
+	}
+
+	mHeight = 0;
+}
+
+void LGlyphAtlas::render( SDL_Renderer* renderer, int x, int y, const char* text )
+{
+	TRACE_ZONE( "LGlyphAtlas::render" );
+
+	if( mTexture == NULL )
+	{
+		return;
+	}
+
+	//One quad per character, the pen moves on by the glyph's width
+	for( const char* c = text; *c != '\0'; c++ )
+	{
+		int g = (unsigned char)*c - firstAtlasGlyph;
+		if( g < 0 || g > lastAtlasGlyph - firstAtlasGlyph )
+		{
+			continue;
+		}
+
+		SDL_Rect renderQuad = { x, y, mGlyphs[g].w, mGlyphs[g].h };
+		SDL_RenderCopy( renderer, mTexture, &mGlyphs[g], &renderQuad );
+		x += mGlyphs[g].w;
+	}
+}
+
+int LGlyphAtlas::getWidth( const char* text )
+{
+	int width = 0;
+	for( const char* c = text; *c != '\0'; c++ )
+	{
+		int g = (unsigned char)*c - firstAtlasGlyph;
+		if( g >= 0 && g <= lastAtlasGlyph - firstAtlasGlyph )
+		{
+			width += mGlyphs[g].w;
+		}
+	}
+	return width;
+}
+
+int LGlyphAtlas::getHeight()
+{
+	return mHeight;
+}
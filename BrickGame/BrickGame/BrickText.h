@@ -0,0 +1,52 @@
+/*Cached text rendering. The font is rasterized once into a glyph atlas texture
+and strings are drawn as a run of clipped quads from it, so drawing text every
+frame costs no surface rasterization and no texture uploads.*/
+
+#pragma once
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+//First and last characters baked into the atlas, printable ASCII
+const int firstAtlasGlyph = 32;
+const int lastAtlasGlyph = 126;
+
+class LGlyphAtlas
+{
+	public:
+		//Initializes variables
+		LGlyphAtlas();
+
+		//Deallocates memory
+		~LGlyphAtlas();
+
+		//Rasterizes every glyph of font in color into one texture
+		bool build( SDL_Renderer* renderer, TTF_Font* font, SDL_Color color );
+
+		//The two halves of build. rasterize only makes a surface, so it can run on a loader thread.
+		bool rasterize( TTF_Font* font, SDL_Color color );
+		bool upload( SDL_Renderer* renderer );
+
+		//Deallocates the atlas
+		void free();
+
+		//Draws text with its top left corner at x, y. Characters outside the atlas are skipped.
+		void render( SDL_Renderer* renderer, int x, int y, const char* text );
+
+		//Width and height text would take up
+		int getWidth( const char* text );
+		int getHeight();
+
+	private:
+		//The texture holding every glyph side by side
+		SDL_Texture* mTexture;
+
+		//The rasterized glyphs between rasterize and upload
+		SDL_Surface* mSurface;
+
+		//Where each glyph sits in the texture, its width is also how far the pen moves
+		SDL_Rect mGlyphs[lastAtlasGlyph - firstAtlasGlyph + 1];
+
+		//Line height
+		int mHeight;
+};
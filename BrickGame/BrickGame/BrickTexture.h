@@ -0,0 +1,70 @@
+/*This source code copyrighted by Lazy Foo' Productions (2004-2015)
+and may not be redistributed without written permission.*/
+
+/*Texture wrapper. Draws with gRenderer and renders text in gFont, which the
+program using it defines.*/
+
+#pragma once
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <string>
+
+//The window renderer
+extern SDL_Renderer* gRenderer;
+
+//Global Font
+extern TTF_Font* gFont;
+
+//Texture wrapper class
+class LTexture
+{
+	public:
+		//Initializes variables
+		LTexture();
+
+		//Deallocates memory
+		~LTexture();
+
+		//Loads image at specified path
+		bool loadFromFile( std::string path );
+
+		//Uploads an already decoded surface, the caller still owns it
+		bool loadFromSurface( SDL_Surface* surface );
+
+		//Takes ownership of a texture created elsewhere
+		bool loadFromTexture( SDL_Texture* texture );
+		
+		//Creates image from font string
+		bool loadFromRenderedText( std::string textureText, SDL_Color textColor );
+
+		//Deallocates texture
+		void free();
+
+		//Set color modulation
+		void setColor( Uint8 red, Uint8 green, Uint8 blue );
+
+		//Set blending
+		void setBlendMode( SDL_BlendMode blending );
+
+		//Set alpha modulation
+		void setAlpha( Uint8 alpha );
+		
+		//Renders texture at given point
+		void render( int x, int y, SDL_Rect* clip = NULL, double angle = 0.0, SDL_Point* center = NULL, SDL_RendererFlip flip = SDL_FLIP_NONE );
+
+		//Gets image dimensions
+		int getWidth();
+		int getHeight();
+
+		//Gets the hardware texture, for batched drawing
+		SDL_Texture* getTexture();
+
+	private:
+		//The actual hardware texture
+		SDL_Texture* mTexture;
+
+		//Image dimensions
+		int mWidth;
+		int mHeight;
+};
@@ -0,0 +1,117 @@
+/*Trace zones for Chrome's trace viewer and Perfetto.*/
+
+#include "BrickTrace.h"
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+long long traceNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+tracebuffer::tracebuffer()
+{
+	for( int i = 0; i < traceCapacity; i++ )
+	{
+		mEvents[i].sequence.store( 0, std::memory_order_relaxed );
+	}
+	mNext.store( 0 );
+}
+
+void tracebuffer::record( const char* name, long long start, long long end )
+{
+	long long n = mNext.fetch_add( 1, std::memory_order_relaxed );
+	traceevent &e = mEvents[n & ( traceCapacity - 1 )];
+
+	//Marked unfinished while it is overwritten, so a dump in between skips it
+	e.sequence.store( 0, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+	e.name = name;
+	e.start = start;
+	e.duration = end - start;
+	e.thread = std::this_thread::get_id();
+	e.sequence.store( n + 1, std::memory_order_release );
+}
+
+long long tracebuffer::recorded() const
+{
+	return mNext.load( std::memory_order_relaxed );
+}
+
+bool tracebuffer::writeJSON( const char* path ) const
+{
+	FILE* file = fopen( path, "w" );
+	if( file == NULL )
+	{
+		printf( "Unable to create trace %s!\n", path );
+		return false;
+	}
+
+	long long last = mNext.load( std::memory_order_acquire );
+	long long first = last > traceCapacity ? last - traceCapacity : 0;
+
+	//Timestamps start at the oldest zone kept, Chrome wants microseconds
+	long long origin = -1;
+	for( long long n = first; n < last; n++ )
+	{
+		const traceevent &e = mEvents[n & ( traceCapacity - 1 )];
+		if( e.sequence.load( std::memory_order_acquire ) == n + 1 && ( origin < 0 || e.start < origin ) )
+		{
+			origin = e.start;
+		}
+	}
+
+	//Threads get small numbers for the trace's tid, in the order they first show up in it
+	std::vector<std::thread::id> threads;
+
+	fprintf( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+	bool comma = false;
+	for( long long n = first; n < last; n++ )
+	{
+		const traceevent &e = mEvents[n & ( traceCapacity - 1 )];
+		if( e.sequence.load( std::memory_order_acquire ) != n + 1 )
+		{
+			continue;
+		}
+
+		//Copy the zone, then check no thread started overwriting it meanwhile
+		const char* name = e.name;
+		long long start = e.start;
+		long long duration = e.duration;
+		std::thread::id id = e.thread;
+		std::atomic_thread_fence( std::memory_order_acquire );
+		if( e.sequence.load( std::memory_order_relaxed ) != n + 1 )
+		{
+			continue;
+		}
+
+		int thread = 1;
+		while( thread <= (int)threads.size() && threads[thread - 1] != id )
+		{
+			thread++;
+		}
+		if( thread > (int)threads.size() )
+		{
+			threads.push_back( id );
+		}
+
+		fprintf( file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", comma ? ",\n" : "",
+			name, thread, ( start - origin ) / 1000.0, duration / 1000.0 );
+		comma = true;
+	}
+	fprintf( file, "\n]}\n" );
+
+	if( fclose( file ) != 0 )
+	{
+		printf( "Unable to write trace %s!\n", path );
+		return false;
+	}
+	return true;
+}
+
+tracebuffer& traceBuffer()
+{
+	static tracebuffer buffer;
+	return buffer;
+}
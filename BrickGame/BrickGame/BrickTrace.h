@@ -0,0 +1,101 @@
+/*Trace zones for Chrome's trace viewer and Perfetto. Plain C++, no SDL.
+
+A zone records its name, start and duration into a fixed ring of events when
+it closes, so a long session keeps its most recent traceCapacity zones.
+writeJSON turns the ring into Chrome trace-event JSON.
+
+Zones only exist when BRICKGAME_TRACE is defined (cmake -DBRICKGAME_TRACE=ON).
+Otherwise the macros expand to nothing and the zones cost nothing.
+
+	TRACE_ZONE( "name" )             zone from here to the end of the scope
+	TRACE_BEGIN( zone, "name" )      zone from here to TRACE_END( zone )
+	TRACE_END( zone )                or to the end of the scope, whichever is first
+
+Names must be string literals or otherwise live until the trace is written.*/
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <stddef.h>
+
+//Zones kept, a power of two
+const int traceCapacity = 1 << 16;
+
+//Nanoseconds on the clock every zone is timed with
+long long traceNow();
+
+class tracebuffer
+{
+public:
+	tracebuffer();
+
+	//Adds a finished zone, safe to call from any thread
+	void record( const char* name, long long start, long long end );
+
+	//Writes the zones in the ring as Chrome trace-event JSON, printing the reason for any failure.
+	//Zones still being recorded by other threads while it runs are left out.
+	bool writeJSON( const char* path ) const;
+
+	//Zones recorded since the program started, including those the ring has since dropped
+	long long recorded() const;
+
+private:
+	struct traceevent
+	{
+		const char* name;
+		long long start;
+		long long duration;
+		std::thread::id thread;
+
+		//Number of the zone held, plus one, set once the rest is written
+		std::atomic<long long> sequence;
+	};
+
+	traceevent mEvents[traceCapacity];
+	std::atomic<long long> mNext;
+};
+
+//The buffer every zone goes to
+tracebuffer& traceBuffer();
+
+//Records the time from construction to end or destruction as one zone
+class tracezone
+{
+public:
+	explicit tracezone( const char* name )
+	{
+		mName = name;
+		mStart = traceNow();
+	}
+
+	~tracezone()
+	{
+		end();
+	}
+
+	void end()
+	{
+		if( mName != NULL )
+		{
+			traceBuffer().record( mName, mStart, traceNow() );
+			mName = NULL;
+		}
+	}
+
+private:
+	const char* mName;
+	long long mStart;
+};
+
+#ifdef BRICKGAME_TRACE
+#define TRACE_CONCAT2( a, b ) a##b
+#define TRACE_CONCAT( a, b ) TRACE_CONCAT2( a, b )
+#define TRACE_ZONE( name ) tracezone TRACE_CONCAT( traceZone, __LINE__ )( name )
+#define TRACE_BEGIN( zone, name ) tracezone zone( name )
+#define TRACE_END( zone ) zone.end()
+#else
+#define TRACE_ZONE( name )
+#define TRACE_BEGIN( zone, name )
+#define TRACE_END( zone )
+#endif
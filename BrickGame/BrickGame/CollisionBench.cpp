@@ -0,0 +1,155 @@
+/*Collision microbenchmark. Scans a whole brick field with some balls three ways:
+checkCollision one brick at a time, the scalar batch kernel and the SIMD batch
+kernel, checks they agree and prints brick tests per second for each.
+
+Usage: CollisionBench [balls]*/
+
+#include "BrickSim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+typedef void (*batchkernel)( const Circle *circles, int numCircles, const brickfield &field, int first, int count, unsigned int *masks );
+
+//Lays count bricks out in a square block with balls scattered over it
+void buildScene(int count, int numBalls, brickfield &field, std::vector<Circle> &balls)
+{
+	int perRow = 1;
+	while(perRow * perRow < count)
+	{
+		perRow++;
+	}
+
+	field.clear();
+	for(int i = 0; i < count; i++)
+	{
+		brick b;
+		b.arrange((i % perRow) * brick::brick_width, (i / perRow) * brick::brick_height);
+		field.add(b);
+	}
+
+	balls.clear();
+	for(int i = 0; i < numBalls; i++)
+	{
+		Circle c;
+		c.x = rand() % (perRow * brick::brick_width);
+		c.y = rand() % ((count / perRow + 1) * brick::brick_height);
+		c.r = ball::ball_WIDTH/2;
+		balls.push_back(c);
+	}
+}
+
+//One pass of checkCollision over every brick for every ball, returns the number of hits
+long long scanPerBrick(brickfield &field, std::vector<Circle> &balls)
+{
+	long long hits = 0;
+	for(int c = 0; c < balls.size(); c++)
+	{
+		for(int i = 0; i < field.size(); i++)
+		{
+			SimRect r = field.rect(i);
+			if(checkCollision(balls[c], r))
+			{
+				hits++;
+			}
+		}
+	}
+	return hits;
+}
+
+//One pass of a batch kernel over the field, 32 bricks per call, returns the number of hits
+long long scanBatch(batchkernel kernel, brickfield &field, std::vector<Circle> &balls, std::vector<unsigned int> &masks)
+{
+	long long hits = 0;
+	for(int first = 0; first < field.size(); first += 32)
+	{
+		int count = field.size() - first < 32 ? field.size() - first : 32;
+		kernel(&balls[0], balls.size(), field, first, count, &masks[0]);
+
+		for(int c = 0; c < balls.size(); c++)
+		{
+			for(unsigned int m = masks[c]; m != 0; m &= m - 1)
+			{
+				hits++;
+			}
+		}
+	}
+	return hits;
+}
+
+//Seconds since start
+double since(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main( int argc, char* args[] )
+{
+	int numBalls = 4;
+	if(argc > 1)
+	{
+		numBalls = atoi(args[1]);
+	}
+
+	const int sizes[] = { 36, 1000, 100000 };
+
+	printf("batch kernel: %s, balls: %d\n", collisionBatchPath(), numBalls);
+	printf("%8s %14s %14s %14s %8s\n", "bricks", "per-brick/s", "scalar/s", "batch/s", "speedup");
+
+	brickfield field;
+	std::vector<Circle> balls;
+	std::vector<unsigned int> masks(numBalls);
+
+	for(int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+	{
+		srand(1);
+		buildScene(sizes[s], numBalls, field, balls);
+
+		//Roughly the same amount of work for every field size
+		long long tests = (long long)field.size() * numBalls;
+		int passes = (int)(50000000 / tests) + 1;
+
+		long long expected = scanPerBrick(field, balls);
+		if(scanBatch(checkCollisionBatchScalar, field, balls, masks) != expected || scanBatch(checkCollisionBatch, field, balls, masks) != expected)
+		{
+			printf("batch kernels disagree with checkCollision on %d bricks\n", sizes[s]);
+			return 1;
+		}
+
+		//Sum the hits so the compiler cannot drop the loops
+		long long sink = 0;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(int p = 0; p < passes; p++)
+		{
+			sink += scanPerBrick(field, balls);
+		}
+		double perBrick = since(start);
+
+		start = std::chrono::steady_clock::now();
+		for(int p = 0; p < passes; p++)
+		{
+			sink += scanBatch(checkCollisionBatchScalar, field, balls, masks);
+		}
+		double scalar = since(start);
+
+		start = std::chrono::steady_clock::now();
+		for(int p = 0; p < passes; p++)
+		{
+			sink += scanBatch(checkCollisionBatch, field, balls, masks);
+		}
+		double batch = since(start);
+
+		double total = (double)tests * passes;
+		printf("%8d %14.0f %14.0f %14.0f %7.1fx\n", sizes[s], total / perBrick, total / scalar, total / batch, perBrick / batch);
+
+		if(sink != expected * passes * 3)
+		{
+			printf("hit counts drifted between passes\n");
+			return 1;
+		}
+	}
+
+	return 0;
+}
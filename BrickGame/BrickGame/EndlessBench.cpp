@@ -0,0 +1,91 @@
+/*Runs endless mode headless for a long session with a bot on the paddle and
+reports, window by window, the tick time, bricks on the field and chunks
+streamed, to check none of them creep up the longer it runs.
+
+Usage: EndlessBench [ticks] [scrollspeed] [seed]
+
+scrollspeed is in pixels per second at the reference tick rate, raise it to
+stream more chunks in fewer ticks.*/
+
+#include "BrickEndless.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+//Peak resident memory in kilobytes, 0 where it can't be read
+long peakMemoryKB()
+{
+#ifndef _WIN32
+	rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#ifdef __APPLE__
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+	}
+#endif
+	return 0;
+}
+
+int main( int argc, char* args[] )
+{
+	long long ticks = argc > 1 ? atoll(args[1]) : 2000000;
+	int scrollSpeed = argc > 2 ? atoi(args[2]) : 600;
+	unsigned int seed = argc > 3 ? (unsigned int)strtoul(args[3], NULL, 10) : 1;
+
+	endlessgame game;
+	game.seed = seed;
+	game.scrollSpeed = scrollSpeed;
+	game.reset();
+	game.handleInput(INPUT_LAUNCH, true);
+	game.handleInput(INPUT_LAUNCH, false);
+
+	printf("ticks: %lld  scroll: %d px/s  seed: %u\n", ticks, scrollSpeed, seed);
+	printf("%12s %10s %10s %10s %10s %8s %10s\n", "tick", "ns/tick", "maxbricks", "chunks", "score", "stalls", "peak KB");
+
+	const int windows = 10;
+	long long perWindow = ticks / windows > 0 ? ticks / windows : 1;
+	int held = -1;
+
+	for(long long done = 0; done < ticks; )
+	{
+		long long count = perWindow < ticks - done ? perWindow : ticks - done;
+		int maxBricks = 0;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(long long t = 0; t < count; t++)
+		{
+			//Keep the paddle under the ball
+			int paddleCentre = game.mainPaddle.mPosX + paddle::paddle_width / 2;
+			int want = game.mainBall.mPosX < paddleCentre - 40 ? INPUT_LEFT : game.mainBall.mPosX > paddleCentre + 40 ? INPUT_RIGHT : -1;
+			if(want != held)
+			{
+				if(held >= 0)
+				{
+					game.handleInput((gameinput)held, false);
+				}
+				if(want >= 0)
+				{
+					game.handleInput((gameinput)want, true);
+				}
+				held = want;
+			}
+
+			game.step();
+			maxBricks = game.gameBricks.size() > maxBricks ? game.gameBricks.size() : maxBricks;
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		done += count;
+
+		printf("%12lld %10.1f %10d %10lld %10lld %8lld %10ld\n", done, seconds * 1e9 / count, maxBricks,
+			game.chunksEntered, game.gamescore, game.stalls(), peakMemoryKB());
+	}
+
+	printf("state hash: %016llx\n", game.stateHash());
+	return 0;
+}
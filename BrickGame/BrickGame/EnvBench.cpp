@@ -0,0 +1,94 @@
+/*Batch environment benchmark. Steps a brickenv with random actions, the way a
+training run would drive it, and prints environment steps per second on 1
+thread and then on more.
+
+Usage: EnvBench [envs] [steps] [maxthreads] [maxticks] [seed]*/
+
+#include "BrickEnv.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+int main( int argc, char* args[] )
+{
+	int numEnvs = 4096;
+	int steps = 2000;
+	int maxThreads = std::thread::hardware_concurrency();
+	int maxTicks = 3600;
+	unsigned int envSeed = 1;
+
+	if(argc > 1)
+	{
+		numEnvs = atoi(args[1]);
+	}
+	if(argc > 2)
+	{
+		steps = atoi(args[2]);
+	}
+	if(argc > 3)
+	{
+		maxThreads = atoi(args[3]);
+	}
+	if(argc > 4)
+	{
+		maxTicks = atoi(args[4]);
+	}
+	if(argc > 5)
+	{
+		envSeed = (unsigned int)strtoul(args[5], NULL, 10);
+	}
+	if(maxThreads < 1)
+	{
+		maxThreads = 1;
+	}
+
+	printf("envs: %d, steps: %d, max ticks: %d, seed: %u, hardware threads: %u\n", numEnvs, steps, maxTicks, envSeed, std::thread::hardware_concurrency());
+	printf("%8s %16s %8s %10s %12s\n", "threads", "env steps/s", "speedup", "episodes", "reward");
+
+	double baseRate = 0;
+
+	//1, 2, 4, ... and maxThreads itself
+	for(int threads = 1; threads <= maxThreads; threads = threads * 2 > maxThreads && threads < maxThreads ? maxThreads : threads * 2)
+	{
+		brickenv env(numEnvs, maxTicks, envSeed);
+		taskpool pool(threads);
+		std::vector<envaction> actions(numEnvs);
+
+		//Actions are held for a few ticks, like a policy that is queried every frame would
+		unsigned int seed = 1;
+		double reward = 0;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(int s = 0; s < steps; s++)
+		{
+			if(s % 8 == 0)
+			{
+				for(int i = 0; i < numEnvs; i++)
+				{
+					seed = seed * 1664525u + 1013904223u;
+					actions[i] = (envaction)((seed >> 16) % 3);
+				}
+			}
+
+			env.step(actions.data(), pool);
+
+			const float* rewards = env.rewards();
+			for(int i = 0; i < numEnvs; i++)
+			{
+				reward += rewards[i];
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		double rate = (double)numEnvs * steps / seconds;
+		if(threads == 1)
+		{
+			baseRate = rate;
+		}
+
+		printf("%8d %16.0f %7.2fx %10lld %12.0f\n", threads, rate, rate / baseRate, env.episodes, reward);
+	}
+
+	return 0;
+}
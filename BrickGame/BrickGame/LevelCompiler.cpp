@@ -0,0 +1,138 @@
+/*Compiles text levels to the binary form the game maps at load.
+
+Usage: LevelCompiler in.txt out.lvl [--nogrid]
+       LevelCompiler --time level [runs]
+       LevelCompiler --generate N out.txt
+
+The compiled level keeps the brick lookup grid unless --nogrid is given, in
+which case the game builds it at load as it does for text levels.
+
+--time loads the level and lays it out into a brickfield and grid the given
+number of times and prints the best time of each, for comparing the two
+forms, and of laying it out again into the same field as a game reset does.
+--generate writes a text level of N bricks of mixed types, stacked above the
+usual field, to have something large to time.*/
+
+#include "BrickLevel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int timeLevel(const char* path, int runs)
+{
+	double bestLoad = 1e9, bestApply = 1e9, bestReset = 1e9;
+	int size = 0;
+	bool grid = false;
+
+	for(int r = 0; r < runs; r++)
+	{
+		bricklevel level;
+		brickfield field;
+		brickgrid lookup;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if(!level.load(path))
+		{
+			return 1;
+		}
+		double load = secondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		level.apply(field, lookup, 1);
+		double apply = secondsSince(start);
+
+		//Again into the same field, as each reset of a game does
+		start = std::chrono::steady_clock::now();
+		level.apply(field, lookup, 2);
+		double reset = secondsSince(start);
+
+		bestLoad = load < bestLoad ? load : bestLoad;
+		bestApply = apply < bestApply ? apply : bestApply;
+		bestReset = reset < bestReset ? reset : bestReset;
+		size = field.size();
+		grid = level.hasGrid();
+	}
+
+	printf("bricks: %d\n", size);
+	printf("precomputed grid: %s\n", grid ? "yes" : "no");
+	printf("load ms: %.3f\n", bestLoad * 1000);
+	printf("lay out ms: %.3f\n", bestApply * 1000);
+	printf("total ms: %.3f\n", (bestLoad + bestApply) * 1000);
+	printf("reset ms: %.3f\n", bestReset * 1000);
+	return 0;
+}
+
+int generateLevel(int count, const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if(file == NULL)
+	{
+		printf("Unable to create level %s!\n", path);
+		return 1;
+	}
+
+	//Full screen width rows stacked upwards from the usual field, out of the ball's reach
+	int perRow = SCREEN_WIDTH / brick::brick_width;
+	int rows = (count + perRow - 1) / perRow;
+	fprintf(file, "name Generated %d\n", count);
+	fprintf(file, "origin 0 %d\n", 20 - (rows - 4) * brick::brick_height);
+	fprintf(file, "grid\n");
+	for(int r = 0; r < rows; r++)
+	{
+		int inRow = count - r * perRow < perRow ? count - r * perRow : perRow;
+		for(int c = 0; c < inRow; c++)
+		{
+			fputc('0' + (r * 7 + c) % numBrickTypes, file);
+		}
+		fputc('\n', file);
+	}
+	fprintf(file, "end\n");
+
+	if(fclose(file) != 0)
+	{
+		printf("Unable to write level %s!\n", path);
+		return 1;
+	}
+	return 0;
+}
+
+int main( int argc, char* args[] )
+{
+	if(argc > 2 && strcmp(args[1], "--time") == 0)
+	{
+		int runs = argc > 3 ? atoi(args[3]) : 10;
+		return timeLevel(args[2], runs > 0 ? runs : 1);
+	}
+
+	if(argc > 3 && strcmp(args[1], "--generate") == 0)
+	{
+		return generateLevel(atoi(args[2]), args[3]);
+	}
+
+	if(argc < 3)
+	{
+		printf("Usage: LevelCompiler in.txt out.lvl [--nogrid]\n       LevelCompiler --time level [runs]\n       LevelCompiler --generate N out.txt\n");
+		return 1;
+	}
+
+	bricklevel level;
+	if(!level.loadText(args[1]))
+	{
+		return 1;
+	}
+
+	bool withGrid = !(argc > 3 && strcmp(args[3], "--nogrid") == 0);
+	if(!level.saveBinary(args[2], withGrid))
+	{
+		return 1;
+	}
+
+	printf("%s: %d bricks%s\n", args[2], level.size(), withGrid ? " and the grid" : "");
+	return 0;
+}
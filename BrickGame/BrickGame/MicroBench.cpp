@@ -0,0 +1,564 @@
+/*Microbenchmark suite for the hot paths: collision tests, ball::move on brick
+fields of 36, 1k and 100k bricks, brick removal and, in builds with SDL, text
+rendering under SDL's dummy video driver.
+
+Every benchmark is run for several samples of at least --mintime seconds and
+reported as nanoseconds per operation, median and fastest sample. Samples are
+taken in rounds, one of each benchmark per round, starting with the
+calibration benchmark, a plain chain of multiplies that only tracks how fast
+the core is running. Each sample is divided by the calibration sample of its
+round, so a busy spell or a clock change lands on both and cancels out. The
+median of those ratios is the benchmark's relative time and the spread
+between their quartiles its noise. After --samples rounds more are run, up to
+--maxsamples, until every benchmark's noise is under half the tolerance.
+Results are written as tab separated lines, one per benchmark:
+
+	name	median_ns	min_ns	ops_per_sample	relative	noise_pct
+
+--baseline compares the relative times against an earlier results file and
+exits with 2 when any benchmark got slower by more than its limit: the
+--tolerance percent, or the noise of the two runs added up if that is more.
+On a quiet machine the noise is a percent or two and the tolerance decides,
+on a busy one the limit widens rather than failing at random.
+
+Usage: MicroBench [--out file] [--baseline file] [--tolerance percent]
+                  [--samples n] [--maxsamples n] [--mintime seconds]
+                  [--filter text] [--media dir]*/
+
+#include "BrickSim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef MICROBENCH_SDL
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "BrickText.h"
+#include "BrickTexture.h"
+#endif
+
+//Runs ops operations and returns the seconds they took, setup left out
+typedef std::function<double( long long ops )> benchbody;
+
+struct benchmark
+{
+	std::string name;
+	benchbody body;
+};
+
+struct benchresult
+{
+	std::string name;
+	double medianNs;
+	double minNs;
+	long long ops;
+
+	//Median time over the calibration's, and spread in percent, from the same rounds
+	double relative;
+	double noise;
+};
+
+//Keeps results alive so the work producing them can't be optimized away
+volatile long long gSink = 0;
+
+//Times ops calls of work
+template<typename Work>
+double timeLoop( long long ops, Work work )
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for( long long i = 0; i < ops; i++ )
+	{
+		work( i );
+	}
+	return std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+}
+
+//count bricks: the 36 of a normal game on screen, the rest in rows stacked above it out of reach
+void buildField( int count, brickgame &game )
+{
+	game.reset();
+
+	int perRow = SCREEN_WIDTH / brick::brick_width;
+	for( int i = 0; game.gameBricks.size() < count; i++ )
+	{
+		brick b;
+		b.arrange( ( i % perRow ) * brick::brick_width, -brick::brick_height * ( i / perRow + 2 ) );
+		game.gameBricks.add( b );
+	}
+	game.grid.build( game.gameBricks );
+}
+
+//Deterministic scatter of test circles and rects over the screen
+void buildShapes( std::vector<Circle> &circles, std::vector<SimRect> &rects )
+{
+	unsigned int random = 1;
+	for( int i = 0; i < 1024; i++ )
+	{
+		Circle c;
+		random = random * 1664525u + 1013904223u;
+		c.x = ( random >> 8 ) % SCREEN_WIDTH;
+		random = random * 1664525u + 1013904223u;
+		c.y = ( random >> 8 ) % SCREEN_HEIGHT;
+		c.r = ball::ball_WIDTH / 2;
+		circles.push_back( c );
+
+		SimRect r;
+		random = random * 1664525u + 1013904223u;
+		r.x = ( random >> 8 ) % SCREEN_WIDTH;
+		random = random * 1664525u + 1013904223u;
+		r.y = ( random >> 8 ) % SCREEN_HEIGHT;
+		r.w = brick::brick_width;
+		r.h = brick::brick_height;
+		rects.push_back( r );
+	}
+}
+
+//Name of the benchmark the others are measured against
+const char* calibrationName = "calibration";
+
+void addSimBenchmarks( std::vector<benchmark> &benches )
+{
+	static std::vector<Circle> circles;
+	static std::vector<SimRect> rects;
+	buildShapes( circles, rects );
+
+	//Each multiply waits on the last, so this only tracks how fast the core is running
+	benchmark calibration = { calibrationName, []( long long ops )
+	{
+		unsigned int random = 1;
+		double seconds = timeLoop( ops, [&]( long long )
+		{
+			random = random * 1664525u + 1013904223u;
+		} );
+		gSink += random;
+		return seconds;
+	} };
+	benches.push_back( calibration );
+
+	benchmark collision = { "checkCollision", []( long long ops )
+	{
+		long long hits = 0;
+		double seconds = timeLoop( ops, [&]( long long i )
+		{
+			hits += checkCollision( circles[i & 1023], rects[( i * 7 ) & 1023] );
+		} );
+		gSink += hits;
+		return seconds;
+	} };
+	benches.push_back( collision );
+
+	benchmark side = { "updateCollisionSide", []( long long ops )
+	{
+		long long sides = 0;
+		double seconds = timeLoop( ops, [&]( long long i )
+		{
+			brickside s = NONE;
+			updateCollisionSide( circles[i & 1023], rects[( i * 7 ) & 1023], s );
+			sides += s;
+		} );
+		gSink += sides;
+		return seconds;
+	} };
+	benches.push_back( side );
+
+	benchmark distance = { "distanceSquared", []( long long ops )
+	{
+		long long total = 0;
+		double seconds = timeLoop( ops, [&]( long long i )
+		{
+			const Circle &a = circles[i & 1023];
+			const Circle &b = circles[( i * 7 ) & 1023];
+			total += distanceSquared( a.x, a.y, b.x, b.y );
+		} );
+		gSink += total;
+		return seconds;
+	} };
+	benches.push_back( distance );
+
+	//ball::move only reads the field, so the ball can bounce around the same field for as long as it takes
+	const int fieldSizes[] = { 36, 1000, 100000 };
+	for( int f = 0; f < 3; f++ )
+	{
+		int count = fieldSizes[f];
+		benchmark move = { "ball::move " + std::to_string( count ), [count]( long long ops )
+		{
+			static brickgame game;
+			buildField( count, game );
+			game.handleInput( INPUT_LAUNCH, true );
+
+			double seconds = timeLoop( ops, [&]( long long )
+			{
+				game.mainBall.move( game.gameBricks, game.grid, game.mainPaddle, game.tickRate );
+			} );
+			gSink += game.mainBall.mPosX;
+			return seconds;
+		} };
+		benches.push_back( move );
+	}
+
+	//Removing bricks from a 100k field, with the grid kept up to date, in a scattered order
+	benchmark removal = { "brick removal 100000", []( long long ops )
+	{
+		static brickgame game;
+		double seconds = 0;
+		unsigned int random = 1;
+
+		while( ops > 0 )
+		{
+			buildField( 100000, game );
+			long long batch = std::min( ops, 50000LL );
+			seconds += timeLoop( batch, [&]( long long )
+			{
+				random = random * 1664525u + 1013904223u;
+				int i = ( random >> 8 ) % game.gameBricks.size();
+				game.grid.remove( game.gameBricks.handleAt( i ).slot, game.gameBricks.rect( i ) );
+				game.gameBricks.removeAt( i );
+			} );
+			ops -= batch;
+		}
+		gSink += game.gameBricks.size();
+		return seconds;
+	} };
+	benches.push_back( removal );
+}
+
+#ifdef MICROBENCH_SDL
+//A software renderer on the dummy video driver, and the game's HUD font. LTexture draws with
+//the same globals the game defines.
+SDL_Renderer* gRenderer = NULL;
+SDL_Surface* gBenchTarget = NULL;
+TTF_Font* gFont = NULL;
+
+bool initText( const std::string &mediaDir )
+{
+	if( getenv( "SDL_VIDEODRIVER" ) == NULL )
+	{
+		SDL_setenv( "SDL_VIDEODRIVER", "dummy", 1 );
+	}
+
+	if( SDL_Init( SDL_INIT_VIDEO ) < 0 || TTF_Init() == -1 )
+	{
+		printf( "SDL could not initialize, skipping text benchmarks! SDL Error: %s\n", SDL_GetError() );
+		return false;
+	}
+
+	gBenchTarget = SDL_CreateRGBSurfaceWithFormat( 0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888 );
+	gRenderer = gBenchTarget != NULL ? SDL_CreateSoftwareRenderer( gBenchTarget ) : NULL;
+	gFont = TTF_OpenFont( ( mediaDir + "/alterebro.ttf" ).c_str(), 28 );
+	if( gRenderer == NULL || gFont == NULL )
+	{
+		printf( "Unable to set up text rendering, skipping text benchmarks! SDL Error: %s\n", SDL_GetError() );
+		return false;
+	}
+
+	return true;
+}
+
+void closeText()
+{
+	if( gFont != NULL )
+	{
+		TTF_CloseFont( gFont );
+	}
+	if( gRenderer != NULL )
+	{
+		SDL_DestroyRenderer( gRenderer );
+	}
+	if( gBenchTarget != NULL )
+	{
+		SDL_FreeSurface( gBenchTarget );
+	}
+	TTF_Quit();
+	SDL_Quit();
+}
+
+void addTextBenchmarks( std::vector<benchmark> &benches )
+{
+	//The game's own LTexture::loadFromRenderedText: rasterize, upload, and free the last one
+	benchmark rendered = { "LTexture::loadFromRenderedText", []( long long ops )
+	{
+		static LTexture texture;
+		SDL_Color black = { 0, 0, 0, 0xFF };
+		char text[32];
+
+		double seconds = timeLoop( ops, [&]( long long i )
+		{
+			snprintf( text, sizeof( text ), "Score: %lld", i % 1000 );
+			texture.loadFromRenderedText( text, black );
+		} );
+
+		texture.free();
+		return seconds;
+	} };
+	benches.push_back( rendered );
+
+	//The glyph atlas the HUD draws with now, for the same strings
+	benchmark atlas = { "LGlyphAtlas::render", []( long long ops )
+	{
+		static LGlyphAtlas glyphs;
+		SDL_Color black = { 0, 0, 0, 0xFF };
+		if( !glyphs.build( gRenderer, gFont, black ) )
+		{
+			return 0.0;
+		}
+
+		char text[32];
+		return timeLoop( ops, [&]( long long i )
+		{
+			snprintf( text, sizeof( text ), "Score: %lld", i % 1000 );
+			glyphs.render( gRenderer, 64, 64, text );
+		} );
+	} };
+	benches.push_back( atlas );
+}
+#endif
+
+//Doubles the ops until one sample takes minSeconds and returns that many
+long long opsPerSample( const benchmark &bench, double minSeconds )
+{
+	long long ops = 1;
+	double seconds = bench.body( ops );
+	while( seconds < minSeconds && ops < ( 1LL << 40 ) )
+	{
+		ops *= seconds > 0 ? std::max( 2LL, std::min( 100LL, (long long)( minSeconds / seconds ) ) ) : 100;
+		seconds = bench.body( ops );
+	}
+	return ops;
+}
+
+//Median and spread between the quartiles, as a percentage of the median, of one benchmark's
+//samples each divided by the calibration sample of the same round
+void relativeTimes( const std::vector<double> &samples, const std::vector<double> &calibration, double &relative, double &noise )
+{
+	std::vector<double> ratios;
+	for( int k = 0; k < samples.size(); k++ )
+	{
+		ratios.push_back( samples[k] / calibration[k] );
+	}
+	std::sort( ratios.begin(), ratios.end() );
+
+	relative = ratios[ratios.size() / 2];
+	noise = ( ratios[ratios.size() * 3 / 4] - ratios[ratios.size() / 4] ) / relative * 100;
+}
+
+//A baseline benchmark's relative time and noise
+struct baselineentry
+{
+	double relative;
+	double noise;
+};
+
+//Reads the relative times and noise from a results file, by benchmark name. Files from before
+//they were written have nothing to compare and are read as empty.
+bool loadBaseline( const char* path, std::map<std::string, baselineentry> &entries )
+{
+	FILE* file = fopen( path, "r" );
+	if( file == NULL )
+	{
+		printf( "Unable to open baseline %s!\n", path );
+		return false;
+	}
+
+	char line[512];
+	while( fgets( line, sizeof( line ), file ) != NULL )
+	{
+		char* tab = strchr( line, '\t' );
+		if( line[0] == '#' || tab == NULL )
+		{
+			continue;
+		}
+		*tab = '\0';
+
+		double median, fastest, relative, noise;
+		long long ops;
+		if( sscanf( tab + 1, "%lf %lf %lld %lf %lf", &median, &fastest, &ops, &relative, &noise ) == 5 )
+		{
+			baselineentry e = { relative, noise };
+			entries[line] = e;
+		}
+	}
+	fclose( file );
+	return true;
+}
+
+int main( int argc, char* args[] )
+{
+	const char* outPath = NULL;
+	const char* baselinePath = NULL;
+	double tolerance = 10;
+	int samples = 8;
+	int maxSamples = 30;
+	double minSeconds = 0.05;
+	std::string filter;
+	std::string mediaDir = "media";
+
+	for( int i = 1; i < argc; i++ )
+	{
+		std::string arg = args[i];
+		if( arg == "--out" && i + 1 < argc )
+		{
+			outPath = args[++i];
+		}
+		else if( arg == "--baseline" && i + 1 < argc )
+		{
+			baselinePath = args[++i];
+		}
+		else if( arg == "--tolerance" && i + 1 < argc )
+		{
+			tolerance = atof( args[++i] );
+		}
+		else if( arg == "--samples" && i + 1 < argc )
+		{
+			samples = std::max( 4, atoi( args[++i] ) );
+		}
+		else if( arg == "--maxsamples" && i + 1 < argc )
+		{
+			maxSamples = atoi( args[++i] );
+		}
+		else if( arg == "--mintime" && i + 1 < argc )
+		{
+			minSeconds = atof( args[++i] );
+		}
+		else if( arg == "--filter" && i + 1 < argc )
+		{
+			filter = args[++i];
+		}
+		else if( arg == "--media" && i + 1 < argc )
+		{
+			mediaDir = args[++i];
+		}
+		else
+		{
+			printf( "Unknown option %s\n", args[i] );
+			return 1;
+		}
+	}
+
+	std::map<std::string, baselineentry> baseline;
+	if( baselinePath != NULL && !loadBaseline( baselinePath, baseline ) )
+	{
+		return 1;
+	}
+
+	std::vector<benchmark> benches;
+	addSimBenchmarks( benches );
+
+	#ifdef MICROBENCH_SDL
+	bool textOn = initText( mediaDir );
+	if( textOn )
+	{
+		addTextBenchmarks( benches );
+	}
+	#endif
+
+	FILE* out = NULL;
+	if( outPath != NULL )
+	{
+		out = fopen( outPath, "w" );
+		if( out == NULL )
+		{
+			printf( "Unable to create %s!\n", outPath );
+			return 1;
+		}
+		fprintf( out, "# name\tmedian_ns\tmin_ns\tops_per_sample\trelative\tnoise_pct\n" );
+	}
+
+	//The calibration always runs and comes first, the rest as the filter says
+	std::vector<benchmark> chosen;
+	for( int b = 0; b < benches.size(); b++ )
+	{
+		if( benches[b].name == calibrationName || filter.empty() || benches[b].name.find( filter ) != std::string::npos )
+		{
+			chosen.push_back( benches[b] );
+		}
+	}
+
+	std::vector<long long> ops;
+	for( int b = 0; b < chosen.size(); b++ )
+	{
+		ops.push_back( opsPerSample( chosen[b], minSeconds ) );
+	}
+
+	//Rounds of one sample each, until every benchmark's noise is well inside the tolerance
+	std::vector<std::vector<double> > perOp( chosen.size() );
+	std::vector<benchresult> results( chosen.size() );
+	for( int round = 0; round < std::max( samples, maxSamples ); round++ )
+	{
+		for( int b = 0; b < chosen.size(); b++ )
+		{
+			perOp[b].push_back( chosen[b].body( ops[b] ) * 1e9 / ops[b] );
+		}
+
+		bool quiet = true;
+		for( int b = 0; b < chosen.size(); b++ )
+		{
+			relativeTimes( perOp[b], perOp[0], results[b].relative, results[b].noise );
+			quiet = quiet && results[b].noise <= tolerance / 2;
+		}
+		if( round + 1 >= samples && quiet )
+		{
+			break;
+		}
+	}
+
+	for( int b = 0; b < chosen.size(); b++ )
+	{
+		std::vector<double> sorted = perOp[b];
+		std::sort( sorted.begin(), sorted.end() );
+
+		results[b].name = chosen[b].name;
+		results[b].medianNs = sorted[sorted.size() / 2];
+		results[b].minNs = sorted[0];
+		results[b].ops = ops[b];
+	}
+
+	printf( "samples: %d\n", (int)perOp[0].size() );
+	printf( "%-32s %12s %12s %9s %9s %9s\n", "benchmark", "median ns", "min ns", "noise", "limit", "change" );
+
+	int regressions = 0;
+	for( int b = 0; b < results.size(); b++ )
+	{
+		const benchresult &r = results[b];
+		if( out != NULL )
+		{
+			fprintf( out, "%s\t%.3f\t%.3f\t%lld\t%.5f\t%.2f\n", r.name.c_str(), r.medianNs, r.minNs, r.ops, r.relative, r.noise );
+		}
+
+		std::map<std::string, baselineentry>::iterator old = baseline.find( r.name );
+		if( old == baseline.end() || old->second.relative <= 0 || b == 0 )
+		{
+			printf( "%-32s %12.3f %12.3f %8.1f%%\n", r.name.c_str(), r.medianNs, r.minNs, r.noise );
+			continue;
+		}
+
+		//A change inside the noise of the two runs can't be told from chance
+		double limit = std::max( tolerance, r.noise + old->second.noise );
+		double change = ( r.relative / old->second.relative - 1 ) * 100;
+		bool regressed = change > limit;
+		regressions += regressed;
+		printf( "%-32s %12.3f %12.3f %8.1f%% %8.1f%% %+8.1f%%%s\n", r.name.c_str(), r.medianNs, r.minNs, r.noise, limit, change, regressed ? "  REGRESSED" : "" );
+	}
+
+	if( out != NULL )
+	{
+		fclose( out );
+	}
+
+	#ifdef MICROBENCH_SDL
+	closeText();
+	#endif
+
+	if( regressions > 0 )
+	{
+		printf( "%d benchmark(s) slower than the baseline by more than their limit\n", regressions );
+		return 2;
+	}
+
+	return 0;
+}
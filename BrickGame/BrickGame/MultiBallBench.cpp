@@ -0,0 +1,71 @@
+/*Multi-ball scaling benchmark. Runs the same multi-ball game on 1 thread and
+then on more, prints balls updated per second for each thread count and checks
+every run ends in exactly the same state as the single threaded one.
+
+Usage: MultiBallBench [balls] [ticks] [maxthreads]*/
+
+#include "BrickMultiBall.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <thread>
+
+int main( int argc, char* args[] )
+{
+	int numBalls = 4096;
+	int ticks = 1000;
+	int maxThreads = std::thread::hardware_concurrency();
+
+	if(argc > 1)
+	{
+		numBalls = atoi(args[1]);
+	}
+	if(argc > 2)
+	{
+		ticks = atoi(args[2]);
+	}
+	if(argc > 3)
+	{
+		maxThreads = atoi(args[3]);
+	}
+	if(maxThreads < 1)
+	{
+		maxThreads = 1;
+	}
+
+	printf("balls: %d, ticks: %d, hardware threads: %u\n", numBalls, ticks, std::thread::hardware_concurrency());
+	printf("%8s %16s %8s %8s %10s %s\n", "threads", "balls/s", "speedup", "steals", "destroyed", "state");
+
+	double baseRate = 0;
+	unsigned long long baseHash = 0;
+
+	//1, 2, 4, ... and maxThreads itself
+	for(int threads = 1; threads <= maxThreads; threads = threads * 2 > maxThreads && threads < maxThreads ? maxThreads : threads * 2)
+	{
+		multiballgame game(numBalls);
+		taskpool pool(threads);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for(int t = 0; t < ticks; t++)
+		{
+			game.step(pool);
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		double rate = (double)numBalls * ticks / seconds;
+		unsigned long long hash = game.stateHash();
+		if(threads == 1)
+		{
+			baseRate = rate;
+			baseHash = hash;
+		}
+
+		printf("%8d %16.0f %7.2fx %8lld %10lld %s\n", threads, rate, rate / baseRate, pool.steals(), game.gamescore, hash == baseHash ? "matches 1 thread" : "DIFFERS");
+		if(hash != baseHash)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*Particle update benchmark. Keeps a pool topped up to a number of live
+particles, some dying every frame, and times particlepool::update and the
+plain C++ update frame by frame against the 1 ms budget. Also runs both side
+by side from the same particles to check they keep the same ones.
+
+Usage: ParticleBench [particles] [frames]*/
+
+#include "BrickParticles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+//What the update is allowed per frame
+const double budgetMs = 1.0;
+
+//Fills pool up to count particles spread over the play area, living half a second to three
+void topUp( particlepool &pool, int count, unsigned int &random )
+{
+	while(pool.size() < count)
+	{
+		random = random * 1664525u + 1013904223u;
+		float x = (float)((random >> 8) % SCREEN_WIDTH);
+		random = random * 1664525u + 1013904223u;
+		float y = (float)((random >> 8) % (SCREEN_HEIGHT - SCOREBOARD_HEIGHT));
+		random = random * 1664525u + 1013904223u;
+		float life = 0.5f + ((random >> 8) % 2500) / 1000.0f;
+		pool.spawn(x, y, (float)((int)(random >> 20) % 400 - 200), -300.0f, life, 0xFFFFFFFFu, (random >> 4) % numBrickTypes);
+	}
+}
+
+//Times frames updates of a pool kept at count particles and prints the mean and worst
+void timeUpdates( const char *name, bool simd, int count, int frames )
+{
+	particlepool pool(count);
+	unsigned int random = 1;
+	const float seconds = 1.0f / 60.0f;
+
+	std::vector<double> ms;
+	long long died = 0;
+	for(int f = 0; f < frames; f++)
+	{
+		topUp(pool, count, random);
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if(simd)
+		{
+			pool.update(seconds);
+		}
+		else
+		{
+			pool.updateScalar(seconds);
+		}
+		ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		died += count - pool.size();
+	}
+
+	std::sort(ms.begin(), ms.end());
+	double total = 0;
+	for(int f = 0; f < frames; f++)
+	{
+		total += ms[f];
+	}
+
+	printf("%-8s %10.3f %10.3f %10.3f %10.1f  %s\n", name, total / frames, ms[frames / 2], ms[frames - 1],
+		(double)died / frames, ms[frames / 2] <= budgetMs ? "within budget" : "OVER BUDGET");
+}
+
+//Runs both updates from the same particles and returns false if they ever keep different ones
+bool compareUpdates( int count, int frames )
+{
+	particlepool simd(count), scalar(count);
+	unsigned int randomA = 7, randomB = 7;
+	const float seconds = 1.0f / 60.0f;
+	float worst = 0;
+
+	for(int f = 0; f < frames; f++)
+	{
+		topUp(simd, count, randomA);
+		topUp(scalar, count, randomB);
+		simd.update(seconds);
+		scalar.updateScalar(seconds);
+
+		if(simd.size() != scalar.size())
+		{
+			printf("frame %d: %d particles kept against %d!\n", f, simd.size(), scalar.size());
+			return false;
+		}
+
+		for(int i = 0; i < simd.size(); i++)
+		{
+			if(simd.sprites()[i] != scalar.sprites()[i] || simd.colors()[i] != scalar.colors()[i])
+			{
+				printf("frame %d: particle %d differs!\n", f, i);
+				return false;
+			}
+			worst = std::max(worst, fabsf(simd.xs()[i] - scalar.xs()[i]));
+			worst = std::max(worst, fabsf(simd.ys()[i] - scalar.ys()[i]));
+		}
+	}
+
+	//Fused multiply adds in one and not the other can move a particle by a rounding step
+	printf("%s and scalar agree over %d frames, largest position difference %g px\n", particleUpdatePath(), frames, worst);
+	return worst < 0.01f;
+}
+
+int main( int argc, char* args[] )
+{
+	int count = argc > 1 ? atoi(args[1]) : 100000;
+	int frames = argc > 2 ? atoi(args[2]) : 600;
+	if(count < 1 || frames < 1)
+	{
+		printf("Usage: ParticleBench [particles] [frames]\n");
+		return 1;
+	}
+
+	printf("particles: %d  frames: %d  budget: %.1f ms\n", count, frames, budgetMs);
+	printf("%-8s %10s %10s %10s %10s\n", "update", "mean ms", "median ms", "worst ms", "died/frame");
+	timeUpdates("scalar", false, count, frames);
+	timeUpdates(particleUpdatePath(), true, count, frames);
+
+	return compareUpdates(count, 120) ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+/*Startup benchmark. Loads the game's images and sounds the three ways the game
+has done it and prints the median and best time of each:
+	serial  IMG_Load and Mix_LoadWAV one after another, the original loadMedia
+	workers the same decodes on LAssetLoader threads, loadMedia without a pack
+	pack    textures and chunks made from the mapped media/assets.pack
+The HUD font is left out, every path rasterizes it the same way. Files are read
+through the OS cache after the first run, so this measures decode and upload
+cost rather than disk time.
+
+Usage: StartupBench [runs], from the directory holding media/*/
+
+#include "BrickAssets.h"
+#include "BrickPack.h"
+#include <SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+//What one load produced, freed between runs
+struct loadedassets
+{
+	SDL_Texture* atlas;
+	Mix_Chunk* brickHit;
+	Mix_Chunk* paddleHit;
+};
+
+void freeAssets( loadedassets& a )
+{
+	SDL_DestroyTexture( a.atlas );
+	Mix_FreeChunk( a.brickHit );
+	Mix_FreeChunk( a.paddleHit );
+}
+
+//Texture from a color keyed surface, as LTexture::loadFromSurface makes it
+SDL_Texture* upload( SDL_Renderer* renderer, SDL_Surface* surface )
+{
+	SDL_Texture* texture = NULL;
+	if( surface != NULL )
+	{
+		texture = SDL_CreateTextureFromSurface( renderer, surface );
+		SDL_FreeSurface( surface );
+	}
+	return texture;
+}
+
+bool loadSerial( SDL_Renderer* renderer, loadedassets& a )
+{
+	SDL_Surface* surface = IMG_Load( "media/atlas.png" );
+	if( surface != NULL )
+	{
+		SDL_SetColorKey( surface, SDL_TRUE, SDL_MapRGB( surface->format, 0, 0xFF, 0xFF ) );
+	}
+	a.atlas = upload( renderer, surface );
+	a.brickHit = Mix_LoadWAV( "media/brickhitsound.wav" );
+	a.paddleHit = Mix_LoadWAV( "media/paddlehitsound.wav" );
+	return a.atlas != NULL && a.brickHit != NULL && a.paddleHit != NULL;
+}
+
+bool loadWorkers( SDL_Renderer* renderer, loadedassets& a )
+{
+	SDL_Surface* surface = NULL;
+
+	LAssetLoader loader;
+	loader.addImage( "media/atlas.png", &surface );
+	loader.addSound( "media/brickhitsound.wav", &a.brickHit );
+	loader.addSound( "media/paddlehitsound.wav", &a.paddleHit );
+	loader.start();
+	bool success = loader.wait();
+
+	a.atlas = upload( renderer, surface );
+	return success && a.atlas != NULL;
+}
+
+//The pack stays mapped while its chunks are alive, like gAssetPack in the game
+LAssetPack gPack;
+
+bool loadPack( SDL_Renderer* renderer, loadedassets& a )
+{
+	bool success = gPack.open( "media/assets.pack" );
+	a.atlas = success ? gPack.createTexture( renderer, "atlas.png" ) : NULL;
+	a.brickHit = success ? gPack.createChunk( "brickhitsound.wav" ) : NULL;
+	a.paddleHit = success ? gPack.createChunk( "paddlehitsound.wav" ) : NULL;
+	return a.atlas != NULL && a.brickHit != NULL && a.paddleHit != NULL;
+}
+
+//Runs load runs times, prints the median and best, returns the median in milliseconds
+double bench( const char* name, bool (*load)( SDL_Renderer*, loadedassets& ), SDL_Renderer* renderer, int runs )
+{
+	std::vector<double> times;
+	for( int r = 0; r < runs; r++ )
+	{
+		loadedassets a = { NULL, NULL, NULL };
+
+		Uint64 start = SDL_GetPerformanceCounter();
+		bool success = load( renderer, a );
+		Uint64 end = SDL_GetPerformanceCounter();
+
+		freeAssets( a );
+		gPack.close();
+
+		if( !success )
+		{
+			printf( "%-8s failed to load\n", name );
+			return 0;
+		}
+		times.push_back( 1000.0 * ( end - start ) / SDL_GetPerformanceFrequency() );
+	}
+
+	std::sort( times.begin(), times.end() );
+	double median = times[times.size() / 2];
+	printf( "%-8s %10.3f %10.3f\n", name, median, times[0] );
+	return median;
+}
+
+int main( int argc, char* args[] )
+{
+	int runs = 20;
+	if( argc > 1 )
+	{
+		runs = atoi( args[1] );
+	}
+	if( runs < 1 )
+	{
+		runs = 1;
+	}
+
+	if( SDL_Init( SDL_INIT_VIDEO | SDL_INIT_AUDIO ) < 0 || !( IMG_Init( IMG_INIT_PNG ) & IMG_INIT_PNG ) )
+	{
+		printf( "SDL could not initialize! SDL Error: %s\n", SDL_GetError() );
+		return 1;
+	}
+
+	//Textures need a renderer, which needs a window, which nobody has to see
+	SDL_Window* window = SDL_CreateWindow( "StartupBench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 64, 64, SDL_WINDOW_HIDDEN );
+	SDL_Renderer* renderer = window != NULL ? SDL_CreateRenderer( window, -1, 0 ) : NULL;
+	if( renderer == NULL || Mix_OpenAudio( mixerFrequency, mixerFormat, mixerChannels, 2048 ) < 0 )
+	{
+		printf( "Unable to create a renderer and open audio! SDL Error: %s\n", SDL_GetError() );
+		return 1;
+	}
+
+	printf( "runs: %d\n", runs );
+	printf( "%-8s %10s %10s\n", "path", "median ms", "best ms" );
+	double serial = bench( "serial", loadSerial, renderer, runs );
+	double workers = bench( "workers", loadWorkers, renderer, runs );
+	double pack = bench( "pack", loadPack, renderer, runs );
+
+	if( pack > 0 )
+	{
+		printf( "pack is %.1fx faster than serial, %.1fx faster than workers\n", serial / pack, workers / pack );
+	}
+
+	Mix_CloseAudio();
+	SDL_DestroyRenderer( renderer );
+	SDL_DestroyWindow( window );
+	IMG_Quit();
+	SDL_Quit();
+
+	return 0;
+}